@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QObject>
+#include <QScopedPointer>
+
+#include "qtrabbitmq_export.h"
+
+namespace qmq {
+class Channel;
+
+//! Coalesces consumer acks on one channel into basic.ack(multiple=true).
+//!
+//! Completed delivery tags are recorded in a sliding bitmap. Once the contiguous prefix of
+//! completed tags has advanced by ackBatchSize() tags, one multiple ack covers all of it.
+//! Tags completed past a gap (out of order) are outliers: they are acked individually when
+//! maxOutliers() of them have built up, or when maxDelayMs() has passed, so that a slow
+//! message does not hold back the acks of everything after it.
+//!
+//! Because a multiple ack covers every earlier tag on the channel, all deliveries of the channel
+//! must be settled through the batcher. Use Channel::ackBatcher() to get the channel's batcher.
+class QTRABBITMQ_EXPORT AckBatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AckBatcher(Channel *channel);
+    ~AckBatcher() override;
+
+    int ackBatchSize() const;
+    void setAckBatchSize(int n);
+    int maxOutliers() const;
+    void setMaxOutliers(int n);
+    int maxDelayMs() const;
+    void setMaxDelayMs(int ms);
+
+    //! Marks \a deliveryTag as processed; it is acked with the next batch.
+    void complete(quint64 deliveryTag);
+    //! Rejects \a deliveryTag now and lets the batch move past it.
+    bool reject(quint64 deliveryTag, bool requeue = false);
+
+    //! Completed tags not yet acked.
+    int pendingCount() const;
+    //! Forgets every tag without acking, as the channel has closed; a reopened channel
+    //! numbers its deliveries from 1 again.
+    void reset();
+
+public Q_SLOTS:
+    //! Acks everything completed so far.
+    void flush();
+
+private:
+    Q_DISABLE_COPY(AckBatcher)
+
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+} // namespace qmq
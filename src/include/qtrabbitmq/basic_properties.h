@@ -0,0 +1,129 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+
+#include "qtrabbitmq.h"
+
+#include "qtrabbitmq_export.h"
+
+namespace qmq {
+
+using BasicPropertyHash = QHash<BasicProperty, QVariant>;
+
+//! The content header properties of the basic class.
+//!
+//! Fixed layout value type: each property is a typed member, and presence is tracked in a
+//! 16-bit mask using the wire encoding of the property flags (ContentType is the high bit).
+//! Copying does not allocate; only the headers table is a node based container.
+//!
+//! The QVariant based value()/setValue() and the BasicPropertyHash conversions are kept for
+//! compatibility with the generic property API.
+class QTRABBITMQ_EXPORT BasicProperties
+{
+public:
+    BasicProperties() = default;
+    static BasicProperties fromHash(const BasicPropertyHash &hash);
+    BasicPropertyHash toHash() const;
+
+    //! Presence flag of \a p, as used in the header frame property flags.
+    static constexpr quint16 flag(BasicProperty p)
+    {
+        return static_cast<quint16>(0x8000u >> static_cast<int>(p));
+    }
+    //! Presence flags, as written to the header frame.
+    quint16 flags() const { return m_flags; }
+
+    bool isEmpty() const { return m_flags == 0; }
+    bool contains(BasicProperty p) const { return (m_flags & flag(p)) != 0; }
+    void remove(BasicProperty p);
+    void clear() { *this = BasicProperties(); }
+
+    QVariant value(BasicProperty p, const QVariant &defaultValue = QVariant()) const;
+    void setValue(BasicProperty p, const QVariant &value);
+
+    const QString &contentType() const { return m_contentType; }
+    void setContentType(const QString &v) { set(&m_contentType, v, BasicProperty::ContentType); }
+
+    const QString &contentEncoding() const { return m_contentEncoding; }
+    void setContentEncoding(const QString &v)
+    {
+        set(&m_contentEncoding, v, BasicProperty::ContentEncoding);
+    }
+
+    const QVariantHash &headers() const { return m_headers; }
+    void setHeaders(const QVariantHash &v) { set(&m_headers, v, BasicProperty::Headers); }
+
+    quint8 deliveryMode() const { return m_deliveryMode; }
+    void setDeliveryMode(quint8 v) { set(&m_deliveryMode, v, BasicProperty::DeliveryMode); }
+
+    quint8 priority() const { return m_priority; }
+    void setPriority(quint8 v) { set(&m_priority, v, BasicProperty::Priority); }
+
+    const QString &correlationId() const { return m_correlationId; }
+    void setCorrelationId(const QString &v)
+    {
+        set(&m_correlationId, v, BasicProperty::CorrelationId);
+    }
+
+    const QString &replyTo() const { return m_replyTo; }
+    void setReplyTo(const QString &v) { set(&m_replyTo, v, BasicProperty::ReplyTo); }
+
+    const QString &expiration() const { return m_expiration; }
+    void setExpiration(const QString &v) { set(&m_expiration, v, BasicProperty::Expiration); }
+
+    const QString &messageId() const { return m_messageId; }
+    void setMessageId(const QString &v) { set(&m_messageId, v, BasicProperty::MessageId); }
+
+    //! Seconds since the epoch, as sent on the wire.
+    qint64 timestampSecs() const { return m_timestamp; }
+    QDateTime timestamp() const { return QDateTime::fromSecsSinceEpoch(m_timestamp); }
+    void setTimestampSecs(qint64 v) { set(&m_timestamp, v, BasicProperty::Timestamp); }
+    void setTimestamp(const QDateTime &v) { setTimestampSecs(v.toSecsSinceEpoch()); }
+
+    const QString &type() const { return m_type; }
+    void setType(const QString &v) { set(&m_type, v, BasicProperty::Type); }
+
+    const QString &userId() const { return m_userId; }
+    void setUserId(const QString &v) { set(&m_userId, v, BasicProperty::UserId); }
+
+    const QString &appId() const { return m_appId; }
+    void setAppId(const QString &v) { set(&m_appId, v, BasicProperty::AppId); }
+
+    //! Reserved, must be empty. Set through setValue().
+    const QString &clusterId() const { return m_clusterId; }
+
+    bool operator==(const BasicProperties &other) const;
+    bool operator!=(const BasicProperties &other) const { return !(*this == other); }
+
+private:
+    template<typename T>
+    void set(T *member, const T &value, BasicProperty p)
+    {
+        *member = value;
+        m_flags |= flag(p);
+    }
+
+    quint16 m_flags = 0;
+    quint8 m_deliveryMode = 0;
+    quint8 m_priority = 0;
+    qint64 m_timestamp = 0;
+    QString m_contentType;
+    QString m_contentEncoding;
+    QString m_correlationId;
+    QString m_replyTo;
+    QString m_expiration;
+    QString m_messageId;
+    QString m_type;
+    QString m_userId;
+    QString m_appId;
+    QString m_clusterId;
+    QVariantHash m_headers;
+};
+
+} // namespace qmq
+
+QTRABBITMQ_EXPORT QDebug operator<<(QDebug debug, const qmq::BasicProperties &properties);
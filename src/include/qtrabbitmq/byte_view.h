@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <qglobal.h>
+
+#include "qtrabbitmq_export.h"
+
+namespace qmq {
+
+//! A read-only window (offset, length) into an implicitly shared QByteArray.
+//! Holding a view keeps the underlying buffer alive; no bytes are copied until
+//! toByteArray() is called on a partial view.
+class QTRABBITMQ_EXPORT ByteView
+{
+public:
+    ByteView() = default;
+    explicit ByteView(const QByteArray &data)
+        : m_data(data)
+        , m_offset(0)
+        , m_size(data.size())
+    {}
+    ByteView(const QByteArray &data, qsizetype offset, qsizetype size)
+        : m_data(data)
+        , m_offset(offset)
+        , m_size(size)
+    {
+        Q_ASSERT(offset >= 0 && size >= 0 && offset + size <= data.size());
+    }
+
+    const char *data() const { return m_data.constData() + m_offset; }
+    const char *constData() const { return data(); }
+    qsizetype size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    QByteArrayView view() const { return QByteArrayView(data(), m_size); }
+
+    //! Sub-view sharing the same buffer. A negative length means up to the end.
+    ByteView mid(qsizetype offset, qsizetype len = -1) const
+    {
+        offset = qBound(qsizetype(0), offset, m_size);
+        if (len < 0 || offset + len > m_size) {
+            len = m_size - offset;
+        }
+        return ByteView(m_data, m_offset + offset, len);
+    }
+
+    //! Returns the viewed bytes. Only copies when the view covers part of the buffer.
+    QByteArray toByteArray() const
+    {
+        if (m_offset == 0 && m_size == m_data.size()) {
+            return m_data;
+        }
+        return QByteArray(data(), m_size);
+    }
+
+    //! The complete buffer this view refers to.
+    const QByteArray &buffer() const { return m_data; }
+    qsizetype offset() const { return m_offset; }
+
+private:
+    QByteArray m_data;
+    qsizetype m_offset = 0;
+    qsizetype m_size = 0;
+};
+
+inline bool operator==(const ByteView &lhs, const ByteView &rhs)
+{
+    return lhs.view() == rhs.view();
+}
+
+inline bool operator!=(const ByteView &lhs, const ByteView &rhs)
+{
+    return !(lhs == rhs);
+}
+
+} // namespace qmq
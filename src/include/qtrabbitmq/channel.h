@@ -7,15 +7,21 @@
 #include "abstract_frame_handler.h"
 #include "consumer.h"
 #include "message.h"
+#include "publish_template.h"
 
 #include "qtrabbitmq_export.h"
 namespace qmq {
+class AckBatcher;
 class Client;
+class Topology;
+class TopologyResult;
 
 enum class ExchangeDeclareOption {
     NoOptions = 0x0,
     Passive = 0x1,
     Durable = 0x2,
+    AutoDelete = 0x4,
+    Internal = 0x8,
     NoWait = 0x10,
 };
 Q_DECLARE_FLAGS(ExchangeDeclareOptions, ExchangeDeclareOption)
@@ -75,10 +81,23 @@ public:
 
     int channelId() const;
 
+    //! Timeout for the requests of this channel; -1 (the default) uses Client::rpcTimeoutMs()
+    //! and 0 disables it. Use Client::withTimeout() for a deadline on a single call.
+    int rpcTimeoutMs() const;
+    void setRpcTimeoutMs(int ms);
+
     bool addConsumer(Consumer *c);
 
-    // TODO enum class ChannelState { Closed, Opening, Open, Closing };
+    enum class ChannelState { Closed, Opening, Open, Closing };
+    ChannelState channelState() const;
+
+    //! Commands may be issued as soon as channelOpen() has been called. While the channel is
+    //! Opening they are held and written together when channel.open-ok arrives. With eager
+    //! pipelining they follow channel.open without waiting for the reply, in the same write when
+    //! issued before control returns to the event loop; the broker handles them in order.
     QFuture<void> channelOpen();
+    bool isEagerPipelining() const;
+    void setEagerPipelining(bool eager);
     QFuture<void> channelFlow(bool active);
     QFuture<void> channelClose(quint16 code = 200,
                                const QString &replyText = QString(),
@@ -124,6 +143,12 @@ public:
     // Returns the message-count
     QFuture<int> queuePurge(const QString &queueName, bool noWait = false);
 
+    //! Declares every exchange, queue and binding of \a topology in one burst, without waiting
+    //! for each reply before sending the next request. The result lists the outcome of each
+    //! item. A failing declare makes the broker close the channel, so the items after it fail
+    //! as well.
+    QFuture<TopologyResult> declareTopology(const Topology &topology);
+
     // Client methods for the "Basic" API.
     QFuture<void> basicQos(quint32 prefetchSize, quint16 prefetchCount, bool global);
 
@@ -142,15 +167,50 @@ public:
                       const BasicPropertyHash &properties = BasicPropertyHash(),
                       PublishOptions opts = PublishOption::NoOptions);
 
+    //! Encodes all \a messages and writes them to the socket at once. Either the whole batch
+    //! is written or, if a message fails to encode, none of it.
+    bool basicPublishBatch(const QList<Message> &messages,
+                           PublishOptions opts = PublishOption::NoOptions);
+
+    //! Pre-encodes basic.publish and the content header for repeated publishing to
+    //! \a exchangeName with \a routingKey and \a properties.
+    PublishTemplate publishTemplate(const QString &exchangeName,
+                                    const QString &routingKey,
+                                    const BasicProperties &properties = BasicProperties(),
+                                    PublishOptions opts = PublishOption::NoOptions);
+    //! Publishes \a payload through a template created by this channel. A non-empty
+    //! \a messageId and a valid \a timestamp replace those of the template.
+    bool basicPublish(const PublishTemplate &publishTemplate,
+                      QByteArrayView payload,
+                      const QString &messageId = QString(),
+                      const QDateTime &timestamp = QDateTime());
+
     bool basicRecoverAsync(bool requeue);
     QFuture<void> basicRecover(bool requeue);
     bool basicAck(quint64 deliveryTag, bool muliple = false);
     // Rabbit extension
     bool basicNack(quint64 deliveryTag, bool muliple = false, bool requeue = false);
     bool basicReject(quint64 deliveryTag, bool requeue);
+    //! Batches the acks of this channel's deliveries; created on first use, owned by the channel.
+    AckBatcher *ackBatcher();
 
     QFuture<void> confirmSelect(bool noWait);
 
+    //! Publisher confirms. After confirmSelect() every publish on the channel is numbered from 1
+    //! and tracked until the broker acks or nacks it.
+    bool isConfirmMode() const;
+    //! Sequence number the next publish will get.
+    quint64 nextPublishSeqNo() const;
+    //! Publishes and returns a future that finishes when the broker acks the message. It fails
+    //! if the message is nacked, cannot be sent, or the channel closes first.
+    QFuture<void> basicPublishConfirmed(const qmq::Message &message,
+                                        PublishOptions opts = PublishOption::NoOptions);
+    //! As basicPublishBatch(), with one future covering every message of the batch.
+    QFuture<void> basicPublishBatchConfirmed(const QList<Message> &messages,
+                                             PublishOptions opts = PublishOption::NoOptions);
+    //! Finishes once every publish sent so far is confirmed; fails if any of them is nacked.
+    QFuture<void> waitForConfirms();
+
     QFuture<void> txSelect();
     QFuture<void> txRollback();
     QFuture<void> txCommit();
@@ -190,6 +250,8 @@ protected:
     bool onBasicRecoverOk(const MethodFrame &frame);
 
     bool onConfirmSelectOk(const MethodFrame &frame);
+    bool onBasicAck(const MethodFrame &frame);
+    bool onBasicNack(const MethodFrame &frame);
 
     bool onTxSelectOk(const MethodFrame &frame);
     bool onTxCommitOk(const MethodFrame &frame);
@@ -199,7 +261,6 @@ protected:
 
     void emptyMessageTracking(int code, const QString &message);
 
-    enum class ChannelState { Closed, Opening, Open, Closing };
 Q_SIGNALS:
     void channelStateChanged(ChannelState state);
 
@@ -210,6 +271,7 @@ protected Q_SLOTS:
 private:
     Q_DISABLE_COPY(Channel)
 
+    friend class PublishBatch;
     class Private;
     QScopedPointer<Private> d;
 };
@@ -1,16 +1,23 @@
 #pragma once
 
 #include "channel.h"
+#include "exception.h"
 #include "frame.h"
 
 #include <QAbstractSocket>
 #include <QFuture>
 #include <QObject>
+#include <QPointer>
+#include <QPromise>
 #include <QScopedPointer>
 #include <QSharedPointer>
 #include <QSslError>
 #include <QString>
 
+#include <functional>
+#include <memory>
+#include <type_traits>
+
 #include "qtrabbitmq_export.h"
 
 namespace qmq {
@@ -29,6 +36,121 @@ public:
     };
     ConnectionState state() const;
 
+    //! Immediate mode writes every frame to the socket as it is sent. Corked mode buffers
+    //! frames and writes them once flushThresholdBytes() is reached, when control returns to
+    //! the event loop, or when flush() is called.
+    enum class WriteMode {
+        Immediate,
+        Corked,
+    };
+    WriteMode writeMode() const;
+    void setWriteMode(WriteMode mode);
+    qint64 flushThresholdBytes() const;
+    void setFlushThresholdBytes(qint64 n);
+
+    //! Outbound bytes not yet handed to the network: buffered frames plus the socket's
+    //! write buffer.
+    qint64 bytesToWrite() const;
+    //! The client stops being writable when bytesToWrite() reaches the high watermark and
+    //! becomes writable again once it drains to the low watermark. A high watermark of 0
+    //! disables the check.
+    bool isWritable() const;
+    qint64 highWatermarkBytes() const;
+    void setHighWatermarkBytes(qint64 n);
+    qint64 lowWatermarkBytes() const;
+    void setLowWatermarkBytes(qint64 n);
+
+    //! What publishing does while the client is not writable: Ignore publishes anyway,
+    //! FailFast makes basicPublish return false, and Queue holds the frames in the client
+    //! until it is writable again, up to publishQueueLimitBytes(). Queue holds every frame,
+    //! not only publishes, so that nothing overtakes them: acks, heartbeats and closes wait
+    //! behind the queued publishes.
+    enum class BackpressurePolicy {
+        Ignore,
+        FailFast,
+        Queue,
+    };
+    BackpressurePolicy backpressurePolicy() const;
+    void setBackpressurePolicy(BackpressurePolicy policy);
+    qint64 publishQueueLimitBytes() const;
+    void setPublishQueueLimitBytes(qint64 n);
+
+    //! The broker blocks a connection that publishes while it is short of memory or disk space,
+    //! and stops reading from it until unblocked; see blocked() and unblocked(). With publish
+    //! gating, publishing on a blocked connection does not write to the socket: each channel
+    //! holds its publishes, and the commands after them to keep their order, and writes them
+    //! once the connection is unblocked. Publishing fails once publishQueueLimitBytes() are held.
+    bool isBlocked() const;
+    bool isPublishGatingEnabled() const;
+    void setPublishGatingEnabled(bool enabled);
+
+    //! Moves the client, its socket and its channels to an internal I/O thread. Call it from
+    //! the client's thread before connecting; the client must not have a parent. Afterwards
+    //! other threads talk to the client through the post*() methods and invoke(), and channels
+    //! are created through invoke() as well. Submissions go through a lock-free queue of
+    //! \a queueCapacity entries and are written to the socket together.
+    bool startIoThread(int queueCapacity = 4096);
+    bool hasIoThread() const;
+
+    //! Thread-safe. Queue work for the I/O thread; false if there is no I/O thread or the
+    //! queue is full, in which case the caller may retry later.
+    bool postPublish(quint16 channelId,
+                     Message message,
+                     PublishOptions opts = PublishOption::NoOptions);
+    bool postAck(quint16 channelId, quint64 deliveryTag, bool multiple = false);
+    bool postNack(quint16 channelId,
+                  quint64 deliveryTag,
+                  bool multiple = false,
+                  bool requeue = false);
+    bool postReject(quint16 channelId, quint64 deliveryTag, bool requeue = false);
+    bool post(std::function<void(Client *)> fn);
+
+    //! Thread-safe. Runs \a fn on the I/O thread and forwards the outcome of the future it
+    //! returns, e.g. client.invoke<QVariantList>([](Client *c) { return ...->queueDeclare(q); }).
+    template<typename T>
+    QFuture<T> invoke(std::function<QFuture<T>(Client *)> fn)
+    {
+        auto promise = std::make_shared<QPromise<T>>();
+        promise->start();
+        QFuture<T> result = promise->future();
+        const bool isPosted = post([promise, fn](Client *client) {
+            fn(client).then([promise](QFuture<T> inner) { forward(promise.get(), inner); });
+        });
+        if (!isPosted) {
+            promise->setException(qmq::Exception(1, "Cannot post to I/O thread"));
+            promise->finish();
+        }
+        return result;
+    }
+
+    //! Deadline for a single call: the returned future fails with a timeout exception (code
+    //! 408) unless \a future finishes within \a timeoutMs, e.g.
+    //! client.withTimeout(channel->queueDeclare(q), 500). The request itself is not cancelled.
+    //! Call it from the client's thread.
+    template<typename T>
+    QFuture<T> withTimeout(QFuture<T> future, int timeoutMs)
+    {
+        auto promise = std::make_shared<QPromise<T>>();
+        promise->start();
+        QFuture<T> result = promise->future();
+        const quint64 timeout = startTimeout(timeoutMs, [promise]() {
+            if (!promise->future().isFinished()) {
+                promise->setException(qmq::Exception(408, "Request timed out"));
+                promise->finish();
+            }
+        });
+        const QPointer<Client> self(this);
+        future.then([promise, self, timeout](QFuture<T> inner) {
+            if (self) {
+                self->cancelTimeout(timeout);
+            }
+            if (!promise->future().isFinished()) {
+                forward(promise.get(), inner);
+            }
+        });
+        return result;
+    }
+
     QUrl connectionUrl() const;
     bool connectToHost(const QUrl &url);
 
@@ -49,13 +171,45 @@ public:
     quint16 heartbeatSeconds() const;
     void setHeartbeatSeconds(quint16 n);
 
+    //! Requests that get no reply within this time fail with a timeout exception. 0 disables
+    //! the timeout. Channel::setRpcTimeoutMs() overrides it for one channel.
+    int rpcTimeoutMs() const;
+    void setRpcTimeoutMs(int ms);
+
+    //! When enabled, a declare or bind that succeeded before on this connection completes at
+    //! once without contacting the broker, if it has the same names, options and arguments.
+    //! A cached queue declare returns the message and consumer counts of the first reply, so
+    //! use a passive declare to read current counts. Passive, no-wait, auto-delete and
+    //! server-named declarations are always sent. The cache is cleared when a channel or the
+    //! connection closes, on any delete or unbind, and when a declaration fails. Disabled by
+    //! default.
+    bool isTopologyCacheEnabled() const;
+    void setTopologyCacheEnabled(bool enabled);
+
+    //! Opening and closing the connection abort the socket when the broker has not completed
+    //! the handshake within this time. 0 disables the timeout.
+    int connectionTimeoutMs() const;
+    void setConnectionTimeoutMs(int ms);
+
+    //! Limits on the frames / bytes dispatched per socket read before control returns to the
+    //! event loop, so that timers and heartbeats keep running under load. 0 means unlimited.
+    int maxFramesPerRead() const;
+    void setMaxFramesPerRead(int n);
+    qint64 maxBytesPerRead() const;
+    void setMaxBytesPerRead(qint64 n);
+
 Q_SIGNALS:
     void connected();
     void disconnected();
+    void writable(bool isWritable);
+    void blocked(const QString &reason);
+    void unblocked();
 
 public Q_SLOTS:
     bool sendFrame(const Frame &f);
     bool sendHeartbeat();
+    //! Writes buffered frames to the socket now.
+    bool flush();
 
     void disconnectFromHost(quint16 code = 200,
                             const QString &replyText = QString(),
@@ -65,6 +219,7 @@ public Q_SLOTS:
 protected Q_SLOTS:
     void onSocketConnected();
     void onSocketReadyRead();
+    void onSocketBytesWritten(qint64 bytes);
     void onSocketErrorOccurred(QAbstractSocket::SocketError error);
     void onSocketStateChanged(QAbstractSocket::SocketState state);
     void onSocketSslErrors(const QList<QSslError> &errors);
@@ -72,6 +227,28 @@ protected Q_SLOTS:
 private:
     Q_DISABLE_COPY(Client)
 
+    bool dispatchFrame(const Frame &frame);
+    quint64 startTimeout(int ms, std::function<void()> callback);
+    void cancelTimeout(quint64 id);
+
+    template<typename T>
+    static void forward(QPromise<T> *promise, QFuture<T> &future)
+    {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                future.waitForFinished();
+            } else {
+                for (const T &value : future.results()) {
+                    promise->addResult(value);
+                }
+            }
+        } catch (...) {
+            promise->setException(std::current_exception());
+        }
+        promise->finish();
+    }
+
+    friend class Channel;
     class Private;
     QScopedPointer<Private> d;
 };
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <QFuture>
+#include <QList>
 #include <QObject>
 #include <QString>
 
+#include <functional>
+
 #include "message.h"
 #include "qtrabbitmq.h"
 
@@ -16,6 +19,11 @@ class QTRABBITMQ_EXPORT Consumer : public QObject
 {
     Q_OBJECT
 public:
+    //! PerMessage emits messageReady() for every delivery. Batched emits messagesReady() once
+    //! per batch: when the socket read that delivered the messages has been handled, when
+    //! batchMaxMessages() have arrived, or after batchMaxDelayMs(), whichever comes first.
+    enum class DeliveryMode { PerMessage, Batched };
+
     Consumer(const QString &consumerTag = QString(), QObject *parent = nullptr);
     ~Consumer() override;
 
@@ -23,13 +31,35 @@ public:
 
     QFuture<QString> consume(Channel *channel, const QString &queue);
 
+    DeliveryMode deliveryMode() const;
+    void setDeliveryMode(DeliveryMode mode);
+    int batchMaxMessages() const;
+    void setBatchMaxMessages(int n);
+    //! With 0 a batch is signalled as soon as control returns to the event loop.
+    int batchMaxDelayMs() const;
+    void setBatchMaxDelayMs(int ms);
+
+    using Handler = std::function<void(const MessageView &)>;
+    //! Direct mode: the channel calls \a handler for each delivery while it handles the frame,
+    //! without queueing, copying the message or emitting a signal. Pass an empty handler to
+    //! go back to queued delivery. The handler must not replace itself while it runs.
+    void setHandler(Handler handler);
+    bool hasHandler() const;
+    const Handler &handler() const;
+
     Message dequeueMessage();
+    //! Moves up to \a maxCount queued messages out of the consumer; all of them if negative.
+    QList<Message> dequeueBatch(int maxCount = -1);
 
     void pushMessage(const qmq::Message &msg);
+    void pushMessage(qmq::Message &&msg);
     bool hasMessage() const;
+    int messageCount() const;
 
 Q_SIGNALS:
     void messageReady();
+    //! Batched mode: \a count messages arrived since the previous signal.
+    void messagesReady(int count);
 
 private:
     class Private;
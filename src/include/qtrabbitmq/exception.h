@@ -28,6 +28,7 @@ public:
     Exception *clone() const override { return new Exception(*this); }
 
     const char *what() const noexcept override { return m_what.constData(); }
+    int code() const noexcept { return m_code; }
 
 private:
     QByteArray m_what; // Required to provide "what".
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <qglobal.h>
+#include <qtrabbitmq/basic_properties.h>
+#include <qtrabbitmq/byte_view.h>
 #include <qtrabbitmq/qtrabbitmq.h>
 
 #include <QIODevice>
@@ -49,6 +51,13 @@ public:
 
     //! maxFrameSize of 0 is treated as unlimited.
     static std::unique_ptr<Frame> readFrame(QIODevice *io, quint32 maxFrameSize, ErrorCode *err);
+    //! Decodes the frame starting at \a *offset in \a buffer and advances \a *offset past it.
+    //! Method arguments and body payloads of the returned frame are views into \a buffer,
+    //! so the buffer must not be modified in place while frames are alive.
+    static std::unique_ptr<Frame> readFrame(const QByteArray &buffer,
+                                            qsizetype *offset,
+                                            quint32 maxFrameSize,
+                                            ErrorCode *err);
     static bool writeFrame(QIODevice *io, quint32 maxFrameSize, const Frame &f);
 
     //! Note that bit type isn't handled here.
@@ -72,12 +81,16 @@ class QTRABBITMQ_EXPORT MethodFrame : public Frame
 {
 public:
     static std::unique_ptr<MethodFrame> fromContent(quint16 channel, const QByteArray &content);
+    static std::unique_ptr<MethodFrame> fromContent(quint16 channel, const ByteView &content);
 
     quint16 classId() const { return m_classId; }
     quint16 methodId() const { return m_methodId; }
 
     QByteArray content() const override;
 
+    //! The packed method arguments, as received.
+    const ByteView &argumentsView() const { return m_arguments; }
+
     QVariantList getArguments(bool *ok = nullptr) const;
     bool setArguments(const QVariantList &values);
 
@@ -91,28 +104,44 @@ public:
         , m_arguments(arguments)
     {}
 
+    MethodFrame(quint16 channel, quint16 classId, quint16 methodId, const ByteView &arguments)
+        : Frame(qmq::FrameType::Method, channel)
+        , m_classId(classId)
+        , m_methodId(methodId)
+        , m_arguments(arguments)
+    {}
+
 private:
     quint16 m_classId = 0;
     quint16 m_methodId = 0;
-    QByteArray m_arguments;
+    ByteView m_arguments;
 };
 
 class QTRABBITMQ_EXPORT HeaderFrame : public Frame
 {
 public:
+    HeaderFrame(quint16 channel,
+                quint16 classId,
+                quint64 contentSize,
+                const BasicProperties &properties);
     HeaderFrame(quint16 channel,
                 quint16 classId,
                 quint64 contentSize,
                 const QHash<qmq::BasicProperty, QVariant> &properties);
     static std::unique_ptr<HeaderFrame> fromContent(quint16 channel, const QByteArray &content);
+    static std::unique_ptr<HeaderFrame> fromContent(quint16 channel, const ByteView &content);
 
     QByteArray content() const override;
 
+    void setBasicProperties(const BasicProperties &properties) { m_properties = properties; }
+    const BasicProperties &basicProperties() const { return m_properties; }
+
+    //! Compatibility accessors; these convert to and from BasicProperties.
     void setProperties(const QHash<qmq::BasicProperty, QVariant> &properties)
     {
-        m_properties = properties;
+        m_properties = BasicProperties::fromHash(properties);
     };
-    const QHash<qmq::BasicProperty, QVariant> &properties() const { return m_properties; };
+    QHash<qmq::BasicProperty, QVariant> properties() const { return m_properties.toHash(); };
 
     quint16 classId() const { return m_classId; }
     quint64 contentSize() const { return m_contentSize; }
@@ -120,7 +149,7 @@ public:
 private:
     quint16 m_classId = 0;
     quint64 m_contentSize = 0;
-    QHash<qmq::BasicProperty, QVariant> m_properties;
+    BasicProperties m_properties;
 };
 
 class QTRABBITMQ_EXPORT BodyFrame : public Frame
@@ -130,16 +159,23 @@ public:
         : Frame(qmq::FrameType::Body, channel)
         , m_body(body)
     {}
+    BodyFrame(quint16 channel, const ByteView &body)
+        : Frame(qmq::FrameType::Body, channel)
+        , m_body(body)
+    {}
 
     static std::unique_ptr<BodyFrame> fromContent(quint16 channel, const QByteArray &content);
+    static std::unique_ptr<BodyFrame> fromContent(quint16 channel, const ByteView &content);
 
-    QByteArray body() const { return m_body; }
-    void setBody(const QByteArray &body) { m_body = body; }
+    //! Copy of the payload. Prefer bodyView() to avoid the copy.
+    QByteArray body() const { return m_body.toByteArray(); }
+    const ByteView &bodyView() const { return m_body; }
+    void setBody(const QByteArray &body) { m_body = ByteView(body); }
 
-    QByteArray content() const override { return m_body; }
+    QByteArray content() const override { return m_body.toByteArray(); }
 
 private:
-    QByteArray m_body;
+    ByteView m_body;
 };
 
 class QTRABBITMQ_EXPORT HeartbeatFrame : public Frame
@@ -150,6 +186,7 @@ public:
     {}
 
     static std::unique_ptr<HeartbeatFrame> fromContent(quint16 channel, const QByteArray &content);
+    static std::unique_ptr<HeartbeatFrame> fromContent(quint16 channel, const ByteView &content);
 
     QByteArray content() const override { return QByteArray(); }
 
@@ -5,13 +5,14 @@
 #include <QMetaType>
 #include <QVariant>
 
+#include "basic_properties.h"
+#include "byte_view.h"
 #include "qtrabbitmq.h"
 
 #include "qtrabbitmq_export.h"
 
 namespace qmq {
 
-using BasicPropertyHash = QHash<BasicProperty, QVariant>;
 class QTRABBITMQ_EXPORT Message
 {
 public:
@@ -23,6 +24,15 @@ public:
         : m_payload(payload)
         , m_exchangeName(exchangeName)
         , m_routingKey(routingKey)
+        , m_properties(BasicProperties::fromHash(properties))
+    {}
+    Message(const QByteArray &payload,
+            const QString &exchangeName,
+            const QString &routingKey,
+            const BasicProperties &properties)
+        : m_payload(payload)
+        , m_exchangeName(exchangeName)
+        , m_routingKey(routingKey)
         , m_properties(properties)
     {}
 
@@ -32,22 +42,27 @@ public:
     {
         return m_properties.value(p, defaultValue);
     }
-    void setProperty(BasicProperty p, const QVariant &value) { m_properties.insert(p, value); }
+    void setProperty(BasicProperty p, const QVariant &value) { m_properties.setValue(p, value); }
     const QByteArray &payload() const { return m_payload; }
     void setPayload(const QByteArray &payload) { m_payload = payload; }
     void setPayload(const QString &payload)
     {
         m_payload = payload.toUtf8();
-        this->setProperty(qmq::BasicProperty::ContentEncoding, "utf-8");
+        m_properties.setContentEncoding(QStringLiteral("utf-8"));
     }
 
     void setPayload(const char *payload)
     {
         m_payload = QByteArray(payload);
-        this->setProperty(qmq::BasicProperty::ContentEncoding, "utf-8");
+        m_properties.setContentEncoding(QStringLiteral("utf-8"));
     }
 
-    const QHash<BasicProperty, QVariant> &properties() const { return m_properties; }
+    const BasicProperties &basicProperties() const { return m_properties; }
+    BasicProperties &basicProperties() { return m_properties; }
+    void setBasicProperties(const BasicProperties &properties) { m_properties = properties; }
+
+    //! Compatibility accessor; converts the properties to a hash.
+    BasicPropertyHash properties() const { return m_properties.toHash(); }
 
     void setRoutingKey(const QString &key) { m_routingKey = key; }
     QString routingKey() const { return m_routingKey; }
@@ -65,11 +80,57 @@ private:
     QByteArray m_payload;
     QString m_exchangeName;
     QString m_routingKey;
-    BasicPropertyHash m_properties;
+    BasicProperties m_properties;
     quint64 m_deliveryTag = 0;
     bool m_redelivered = false;
 };
 
+//! A delivery borrowed from the channel's receive state. It is only valid while the consumer
+//! handler it is passed to runs; use toMessage() to keep it. A body that arrived in one frame
+//! is viewed in the receive buffer, so the payload is not copied until toMessage().
+class MessageView
+{
+public:
+    MessageView(const ByteView &payload,
+                const QString &exchangeName,
+                const QString &routingKey,
+                const BasicProperties &properties,
+                quint64 deliveryTag,
+                bool redelivered)
+        : m_payload(payload)
+        , m_exchangeName(exchangeName)
+        , m_routingKey(routingKey)
+        , m_properties(properties)
+        , m_deliveryTag(deliveryTag)
+        , m_redelivered(redelivered)
+    {}
+
+    const ByteView &payload() const { return m_payload; }
+    const QString &exchangeName() const { return m_exchangeName; }
+    const QString &routingKey() const { return m_routingKey; }
+    const BasicProperties &basicProperties() const { return m_properties; }
+    quint64 deliveryTag() const { return m_deliveryTag; }
+    bool isRedelivered() const { return m_redelivered; }
+
+    Message toMessage() const
+    {
+        Message msg(m_payload.toByteArray(), m_exchangeName, m_routingKey, m_properties);
+        msg.setDeliveryTag(m_deliveryTag);
+        msg.setRedelivered(m_redelivered);
+        return msg;
+    }
+
+private:
+    Q_DISABLE_COPY(MessageView)
+
+    const ByteView &m_payload;
+    const QString &m_exchangeName;
+    const QString &m_routingKey;
+    const BasicProperties &m_properties;
+    quint64 m_deliveryTag;
+    bool m_redelivered;
+};
+
 } // namespace qmq
 
 QTRABBITMQ_EXPORT QDebug operator<<(QDebug debug, const qmq::Message &message);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFuture>
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+#include <functional>
+
+#include "message.h"
+
+#include "qtrabbitmq_export.h"
+
+namespace qmq {
+class Channel;
+
+//! Consumes a queue and processes the deliveries on a pool of worker threads.
+//!
+//! Each delivery is given a partition key, and all messages with the same key go to the same
+//! worker, so they are processed in delivery order. Deliveries reach the workers through
+//! lock-free single-producer rings; results come back the same way and are acked on the
+//! channel's thread through Channel::ackBatcher(), which orders them by delivery tag.
+//!
+//! The work handler runs on the worker threads and must not touch the Client or Channel.
+class QTRABBITMQ_EXPORT ParallelConsumer : public QObject
+{
+    Q_OBJECT
+public:
+    //! Returns true to ack the message, false to reject it.
+    using WorkHandler = std::function<bool(const Message &)>;
+    using PartitionKeyFunction = std::function<QByteArray(const MessageView &)>;
+
+    explicit ParallelConsumer(int workerCount,
+                              const QString &consumerTag = QString(),
+                              QObject *parent = nullptr);
+    ~ParallelConsumer() override;
+
+    QString consumerTag() const;
+    int workerCount() const;
+
+    //! Must be set before consume().
+    void setWorkHandler(WorkHandler handler);
+
+    //! Partitions by routing key. This is the default.
+    void setPartitionByRoutingKey();
+    //! Partitions by the value of the header \a name; messages without it share one partition.
+    void setPartitionByHeader(const QString &name);
+    void setPartitionKeyFunction(PartitionKeyFunction fn);
+
+    //! Rejected messages are requeued when set; off by default.
+    bool requeueOnFailure() const;
+    void setRequeueOnFailure(bool requeue);
+
+    //! Starts the workers and consumes \a queue. Every delivery of \a channel is then settled
+    //! through its ack batcher.
+    QFuture<QString> consume(Channel *channel, const QString &queue);
+
+    //! Deliveries handed to the workers and not yet settled.
+    int inFlightCount() const;
+
+private:
+    Q_DISABLE_COPY(ParallelConsumer)
+
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+} // namespace qmq
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QFuture>
+#include <QScopedPointer>
+#include <QString>
+
+#include "channel.h"
+#include "message.h"
+#include "publish_template.h"
+
+#include "qtrabbitmq_export.h"
+
+namespace qmq {
+
+//! Builds a burst of publishes on one channel and hands them to the socket in one write.
+//!
+//! Messages are encoded as they are added, so add() fails early on a message that cannot be
+//! encoded and leaves the batch unchanged. publish() writes the batch and empties it.
+class QTRABBITMQ_EXPORT PublishBatch
+{
+public:
+    explicit PublishBatch(Channel *channel);
+    ~PublishBatch();
+
+    bool add(const Message &message, PublishOptions opts = PublishOption::NoOptions);
+    bool add(const PublishTemplate &publishTemplate,
+             QByteArrayView payload,
+             const QString &messageId = QString(),
+             const QDateTime &timestamp = QDateTime());
+
+    //! Number of messages added since the last publish() or clear().
+    int size() const;
+    bool isEmpty() const { return size() == 0; }
+    //! Bytes of encoded frames waiting to be published.
+    qsizetype encodedSize() const;
+
+    void clear();
+    bool publish();
+    //! Publishes, returning a future that finishes when the broker has acked every message of
+    //! the batch. Requires the channel to be in confirm mode.
+    QFuture<void> publishConfirmed();
+
+private:
+    Q_DISABLE_COPY(PublishBatch)
+
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+} // namespace qmq
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QString>
+
+#include "basic_properties.h"
+
+#include "qtrabbitmq_export.h"
+
+namespace qmq {
+
+namespace detail {
+class ByteWriter;
+class FrameWriter;
+} // namespace detail
+
+//! A pre-encoded publish to a fixed exchange and routing key with fixed properties.
+//!
+//! Created by Channel::publishTemplate(). The basic.publish frame and the content header
+//! properties are serialized once; publishing through the template only writes the body size,
+//! the per-message MessageId and Timestamp, and copies the payload.
+//!
+//! A template is bound to the channel that created it.
+class QTRABBITMQ_EXPORT PublishTemplate
+{
+public:
+    PublishTemplate() = default;
+
+    bool isValid() const { return !m_methodFrame.isEmpty(); }
+    quint16 channelId() const { return m_channelId; }
+    QString exchangeName() const { return m_exchangeName; }
+    QString routingKey() const { return m_routingKey; }
+    const BasicProperties &basicProperties() const { return m_properties; }
+
+private:
+    friend class Channel;
+    friend class PublishBatch;
+
+    PublishTemplate(quint16 channelId,
+                    const QByteArray &methodFrame,
+                    const QString &exchangeName,
+                    const QString &routingKey,
+                    const BasicProperties &properties);
+
+    //! Appends the method, header and body frames of one message to \a writer. Nothing is
+    //! appended on failure.
+    bool write(detail::FrameWriter *writer,
+               QByteArrayView payload,
+               const QString &messageId,
+               const QDateTime &timestamp) const;
+    //! Property flags and properties, with \a messageId and \a timestamp replacing those of
+    //! the template when they are set.
+    bool writeProperties(detail::ByteWriter *out,
+                         const QString &messageId,
+                         const QDateTime &timestamp) const;
+
+    quint16 m_channelId = 0;
+    QByteArray m_methodFrame;
+    QString m_exchangeName;
+    QString m_routingKey;
+    BasicProperties m_properties;
+    // The encoded properties that precede MessageId and those that follow Timestamp.
+    QByteArray m_leadingProperties;
+    QByteArray m_trailingProperties;
+};
+
+} // namespace qmq
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVariantHash>
+
+#include "channel.h"
+
+#include "qtrabbitmq_export.h"
+
+class QJsonObject;
+
+namespace qmq {
+
+//! Exchanges, queues and bindings to declare together with Channel::declareTopology().
+//!
+//! Entities are declared in the order they are added. fromJson() reads the "exchanges",
+//! "queues" and "bindings" arrays of a RabbitMQ definitions export.
+class QTRABBITMQ_EXPORT Topology
+{
+public:
+    struct Item
+    {
+        enum class Kind { Exchange, Queue, QueueBinding, ExchangeBinding };
+        Kind kind = Kind::Exchange;
+        //! Exchange or queue name; for bindings the destination.
+        QString name;
+        //! Bindings only: the exchange bound from.
+        QString source;
+        QString routingKey;
+        Channel::ExchangeType exchangeType = Channel::ExchangeType::Direct;
+        ExchangeDeclareOptions exchangeOptions;
+        QueueDeclareOptions queueOptions;
+        QVariantHash arguments;
+    };
+
+    Topology &addExchange(const QString &name,
+                          Channel::ExchangeType type,
+                          ExchangeDeclareOptions opts = ExchangeDeclareOption::NoOptions,
+                          const QVariantHash &arguments = QVariantHash());
+    Topology &addQueue(const QString &name,
+                       QueueDeclareOptions opts = QueueDeclareOption::NoOptions,
+                       const QVariantHash &arguments = QVariantHash());
+    Topology &addQueueBinding(const QString &queue,
+                              const QString &exchange,
+                              const QString &routingKey = QString(),
+                              const QVariantHash &arguments = QVariantHash());
+    Topology &addExchangeBinding(const QString &destination,
+                                 const QString &source,
+                                 const QString &routingKey = QString(),
+                                 const QVariantHash &arguments = QVariantHash());
+
+    const QList<Item> &items() const { return m_items; }
+    bool isEmpty() const { return m_items.isEmpty(); }
+    qsizetype size() const { return m_items.size(); }
+
+    //! On failure returns an empty topology and sets \a errorString.
+    static Topology fromJson(const QJsonObject &definitions, QString *errorString = nullptr);
+    static Topology fromJson(const QByteArray &json, QString *errorString = nullptr);
+
+private:
+    QList<Item> m_items;
+};
+
+//! Outcome of Channel::declareTopology(), one entry per topology item in the same order.
+class QTRABBITMQ_EXPORT TopologyResult
+{
+public:
+    struct ItemResult
+    {
+        Topology::Item item;
+        //! 0 when the item was declared.
+        int errorCode = 0;
+        QString errorText;
+        bool isOk() const { return errorCode == 0; }
+    };
+
+    bool isOk() const;
+    const QList<ItemResult> &results() const { return m_results; }
+    QList<ItemResult> failures() const;
+
+private:
+    friend class Channel;
+    QList<ItemResult> m_results;
+};
+
+} // namespace qmq
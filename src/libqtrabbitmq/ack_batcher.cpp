@@ -0,0 +1,219 @@
+#include <qtrabbitmq/ack_batcher.h>
+#include <qtrabbitmq/channel.h>
+
+#include <QDebug>
+#include <QPointer>
+#include <QTimer>
+
+#include <deque>
+#include <set>
+
+namespace qmq {
+
+class AckBatcher::Private
+{
+public:
+    bool isCompleted(quint64 tag) const
+    {
+        if (tag < base) {
+            return true;
+        }
+        const quint64 index = tag - wordBase;
+        const size_t word = size_t(index / 64);
+        return word < words.size() && (words[word] & (quint64(1) << (index % 64))) != 0;
+    }
+
+    void markCompleted(quint64 tag)
+    {
+        const quint64 index = tag - wordBase;
+        const size_t word = size_t(index / 64);
+        if (word >= words.size()) {
+            words.resize(word + 1, 0);
+        }
+        words[word] |= quint64(1) << (index % 64);
+    }
+
+    //! Moves base past the completed prefix, dropping bitmap words it has left behind.
+    void advance()
+    {
+        while (!words.empty()) {
+            const quint64 offset = base - wordBase;
+            const quint64 rest = words.front() >> offset;
+            base += qCountTrailingZeroBits(~rest);
+            if (base - wordBase < 64) {
+                break;
+            }
+            words.pop_front();
+            wordBase += 64;
+        }
+        unsentOutliers.erase(unsentOutliers.begin(), unsentOutliers.lower_bound(base));
+    }
+
+    //! Acks the completed prefix with one multiple ack.
+    bool flushPrefix()
+    {
+        const quint64 last = base - 1;
+        if (last <= ackedThrough) {
+            return true;
+        }
+        // The ack must name a tag that is still unacked, or the broker rejects it.
+        quint64 tag = last;
+        while (tag > ackedThrough && settledIndividually.count(tag) != 0) {
+            --tag;
+        }
+        bool isOk = true;
+        if (tag > ackedThrough) {
+            isOk = channel->basicAck(tag, true);
+        }
+        ackedThrough = last;
+        settledIndividually.erase(settledIndividually.begin(),
+                                  settledIndividually.upper_bound(last));
+        return isOk;
+    }
+
+    bool flushOutliers()
+    {
+        bool isOk = true;
+        for (const quint64 tag : unsentOutliers) {
+            isOk = channel->basicAck(tag, false) && isOk;
+            settledIndividually.insert(tag);
+        }
+        unsentOutliers.clear();
+        return isOk;
+    }
+
+    int pendingCount() const { return int(base - 1 - ackedThrough) + int(unsentOutliers.size()); }
+
+    QPointer<Channel> channel;
+    QTimer timer;
+    int ackBatchSize = 64;
+    int maxOutliers = 64;
+    int maxDelayMs = 100;
+
+    // Bit i of words[w] is set when tag wordBase + 64 * w + i is completed. All tags below
+    // base are completed, and all up to ackedThrough are acked.
+    std::deque<quint64> words;
+    quint64 wordBase = 1;
+    quint64 base = 1;
+    quint64 ackedThrough = 0;
+    // Completed past a gap, not acked yet.
+    std::set<quint64> unsentOutliers;
+    // Above ackedThrough but already acked or rejected on their own.
+    std::set<quint64> settledIndividually;
+};
+
+AckBatcher::AckBatcher(Channel *channel)
+    : QObject(channel)
+    , d(new Private)
+{
+    d->channel = channel;
+    d->timer.setSingleShot(true);
+    connect(&d->timer, &QTimer::timeout, this, &AckBatcher::flush);
+}
+
+AckBatcher::~AckBatcher() = default;
+
+int AckBatcher::ackBatchSize() const
+{
+    return d->ackBatchSize;
+}
+
+void AckBatcher::setAckBatchSize(int n)
+{
+    d->ackBatchSize = n;
+}
+
+int AckBatcher::maxOutliers() const
+{
+    return d->maxOutliers;
+}
+
+void AckBatcher::setMaxOutliers(int n)
+{
+    d->maxOutliers = n;
+}
+
+int AckBatcher::maxDelayMs() const
+{
+    return d->maxDelayMs;
+}
+
+void AckBatcher::setMaxDelayMs(int ms)
+{
+    d->maxDelayMs = ms;
+}
+
+void AckBatcher::complete(quint64 deliveryTag)
+{
+    if (!d->channel) {
+        qWarning() << "Cannot ack" << deliveryTag << ": channel gone";
+        return;
+    }
+    if (deliveryTag == 0 || d->isCompleted(deliveryTag)) {
+        qWarning() << "Delivery tag already completed" << deliveryTag;
+        return;
+    }
+    d->markCompleted(deliveryTag);
+    if (deliveryTag == d->base) {
+        d->advance();
+    } else {
+        d->unsentOutliers.insert(deliveryTag);
+    }
+
+    if (d->base - 1 - d->ackedThrough >= quint64(qMax(d->ackBatchSize, 1))) {
+        d->flushPrefix();
+    }
+    if (int(d->unsentOutliers.size()) >= qMax(d->maxOutliers, 1)) {
+        d->flushOutliers();
+    }
+    if (d->pendingCount() > 0 && !d->timer.isActive()) {
+        d->timer.start(d->maxDelayMs);
+    }
+}
+
+bool AckBatcher::reject(quint64 deliveryTag, bool requeue)
+{
+    if (!d->channel) {
+        qWarning() << "Cannot reject" << deliveryTag << ": channel gone";
+        return false;
+    }
+    if (deliveryTag == 0 || d->isCompleted(deliveryTag)) {
+        qWarning() << "Delivery tag already completed" << deliveryTag;
+        return false;
+    }
+    const bool isOk = d->channel->basicReject(deliveryTag, requeue);
+    d->markCompleted(deliveryTag);
+    d->settledIndividually.insert(deliveryTag);
+    if (deliveryTag == d->base) {
+        d->advance();
+    }
+    return isOk;
+}
+
+int AckBatcher::pendingCount() const
+{
+    return d->pendingCount();
+}
+
+void AckBatcher::reset()
+{
+    d->timer.stop();
+    d->words.clear();
+    d->wordBase = 1;
+    d->base = 1;
+    d->ackedThrough = 0;
+    d->unsentOutliers.clear();
+    d->settledIndividually.clear();
+}
+
+void AckBatcher::flush()
+{
+    d->timer.stop();
+    if (!d->channel) {
+        return;
+    }
+    d->flushPrefix();
+    d->flushOutliers();
+}
+
+} // namespace qmq
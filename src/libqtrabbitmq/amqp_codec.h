@@ -0,0 +1,138 @@
+#pragma once
+
+#include "byte_cursor.h"
+#include "byte_writer.h"
+
+#include <qtrabbitmq/basic_properties.h>
+#include <qtrabbitmq/frame.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QVariant>
+#include <QtEndian>
+
+#include <array>
+
+namespace qmq::detail {
+
+// Primitive AMQP field codecs used by the generated method structs (spec_methods.h).
+//
+// The readers never set *ok to true; they only clear it on failure. This allows a sequence
+// of reads to share one flag that is checked once at the end.
+
+template<typename T>
+T readValue(ByteCursor *in, bool *ok)
+{
+    std::array<char, sizeof(T)> buffer;
+    if (in->read(buffer.data(), qint64(buffer.size())) != qint64(buffer.size())) {
+        *ok = false;
+        return T();
+    }
+    return qFromBigEndian<T>(buffer.data());
+}
+
+inline QString readShortStr(ByteCursor *in, bool *ok)
+{
+    const quint8 len = readValue<quint8>(in, ok);
+    if (in->bytesAvailable() < len) {
+        *ok = false;
+        return QString();
+    }
+    const QString result = QString::fromUtf8(in->current(), len);
+    in->skip(len);
+    return result;
+}
+
+inline QByteArray readLongStr(ByteCursor *in, bool *ok)
+{
+    const quint32 len = readValue<quint32>(in, ok);
+    if (in->bytesAvailable() < len) {
+        *ok = false;
+        return QByteArray();
+    }
+    return in->read(len);
+}
+
+inline QDateTime readTimestamp(ByteCursor *in, bool *ok)
+{
+    return QDateTime::fromSecsSinceEpoch(readValue<qint64>(in, ok));
+}
+
+//! Defined in frame.cpp, next to the general field value decoder.
+QVariantHash readTable(ByteCursor *in, bool *ok);
+
+template<typename T>
+void writeValue(ByteWriter *out, T value)
+{
+    std::array<char, sizeof(T)> buffer;
+    qToBigEndian<T>(value, buffer.data());
+    out->write(buffer.data(), qint64(buffer.size()));
+}
+
+inline bool writeShortStr(ByteWriter *out, const QString &value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    if (utf8.size() > 0xFF) {
+        qWarning() << "string too long";
+        return false;
+    }
+    writeValue<quint8>(out, quint8(utf8.size()));
+    out->write(utf8);
+    return true;
+}
+
+inline bool writeLongStr(ByteWriter *out, const QByteArray &value)
+{
+    writeValue<quint32>(out, quint32(value.size()));
+    out->write(value);
+    return true;
+}
+
+inline void writeTimestamp(ByteWriter *out, const QDateTime &value)
+{
+    writeValue<qint64>(out, value.toSecsSinceEpoch());
+}
+
+//! Defined in frame.cpp, next to the general field value encoder.
+bool writeTable(ByteWriter *out, const QVariantHash &value);
+
+//! Property flags followed by the present properties, as in a content header frame.
+//! Defined in basic_properties.cpp.
+bool writeBasicProperties(ByteWriter *out, const BasicProperties &props);
+bool readBasicProperties(ByteCursor *in, BasicProperties *props);
+
+//! Builds a method frame from one of the generated method structs.
+template<typename Method>
+MethodFrame encodeMethod(quint16 channel, const Method &method, bool *ok = nullptr)
+{
+    QByteArray arguments;
+    ByteWriter out(&arguments);
+    const bool isOk = method.encode(&out);
+    if (!isOk) {
+        qWarning() << "Failed to encode" << Method::Name;
+    }
+    if (ok != nullptr) {
+        *ok = isOk;
+    }
+    return MethodFrame(channel, Method::ClassId, Method::MethodId, arguments);
+}
+
+//! Decodes the arguments of \a frame into one of the generated method structs.
+template<typename Method>
+bool decodeMethod(const MethodFrame &frame, Method *method)
+{
+    if (frame.classId() != Method::ClassId || frame.methodId() != Method::MethodId) {
+        qWarning() << "Method frame" << frame.classId() << frame.methodId() << "is not"
+                   << Method::Name;
+        return false;
+    }
+    ByteCursor in(frame.argumentsView());
+    if (!method->decode(&in)) {
+        qWarning() << "Failed to decode" << Method::Name;
+        return false;
+    }
+    return true;
+}
+
+} // namespace qmq::detail
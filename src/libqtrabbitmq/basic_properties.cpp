@@ -0,0 +1,325 @@
+#include "amqp_codec.h"
+#include <qtrabbitmq/basic_properties.h>
+
+#include <QDebug>
+
+namespace qmq {
+
+namespace {
+constexpr const int basicPropertyCount = static_cast<int>(BasicProperty::_ClusterId) + 1;
+constexpr const quint16 basicPropertyMask = static_cast<quint16>(
+    0xFFFFu << (16 - basicPropertyCount));
+} // namespace
+
+BasicProperties BasicProperties::fromHash(const BasicPropertyHash &hash)
+{
+    BasicProperties result;
+    for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
+        result.setValue(it.key(), it.value());
+    }
+    return result;
+}
+
+BasicPropertyHash BasicProperties::toHash() const
+{
+    BasicPropertyHash result;
+    for (int i = 0; i < basicPropertyCount; ++i) {
+        const BasicProperty p = static_cast<BasicProperty>(i);
+        if (contains(p)) {
+            result.insert(p, value(p));
+        }
+    }
+    return result;
+}
+
+void BasicProperties::remove(BasicProperty p)
+{
+    switch (p) {
+    case BasicProperty::ContentType:
+        m_contentType.clear();
+        break;
+    case BasicProperty::ContentEncoding:
+        m_contentEncoding.clear();
+        break;
+    case BasicProperty::Headers:
+        m_headers.clear();
+        break;
+    case BasicProperty::DeliveryMode:
+        m_deliveryMode = 0;
+        break;
+    case BasicProperty::Priority:
+        m_priority = 0;
+        break;
+    case BasicProperty::CorrelationId:
+        m_correlationId.clear();
+        break;
+    case BasicProperty::ReplyTo:
+        m_replyTo.clear();
+        break;
+    case BasicProperty::Expiration:
+        m_expiration.clear();
+        break;
+    case BasicProperty::MessageId:
+        m_messageId.clear();
+        break;
+    case BasicProperty::Timestamp:
+        m_timestamp = 0;
+        break;
+    case BasicProperty::Type:
+        m_type.clear();
+        break;
+    case BasicProperty::UserId:
+        m_userId.clear();
+        break;
+    case BasicProperty::AppId:
+        m_appId.clear();
+        break;
+    case BasicProperty::_ClusterId:
+        m_clusterId.clear();
+        break;
+    default:
+        qWarning() << "Unknown basic property" << (int) p;
+        return;
+    }
+    m_flags &= static_cast<quint16>(~flag(p));
+}
+
+QVariant BasicProperties::value(BasicProperty p, const QVariant &defaultValue) const
+{
+    if (!contains(p)) {
+        return defaultValue;
+    }
+    switch (p) {
+    case BasicProperty::ContentType:
+        return m_contentType;
+    case BasicProperty::ContentEncoding:
+        return m_contentEncoding;
+    case BasicProperty::Headers:
+        return m_headers;
+    case BasicProperty::DeliveryMode:
+        return QVariant::fromValue(m_deliveryMode);
+    case BasicProperty::Priority:
+        return QVariant::fromValue(m_priority);
+    case BasicProperty::CorrelationId:
+        return m_correlationId;
+    case BasicProperty::ReplyTo:
+        return m_replyTo;
+    case BasicProperty::Expiration:
+        return m_expiration;
+    case BasicProperty::MessageId:
+        return m_messageId;
+    case BasicProperty::Timestamp:
+        return timestamp();
+    case BasicProperty::Type:
+        return m_type;
+    case BasicProperty::UserId:
+        return m_userId;
+    case BasicProperty::AppId:
+        return m_appId;
+    case BasicProperty::_ClusterId:
+        return m_clusterId;
+    default:
+        return defaultValue;
+    }
+}
+
+void BasicProperties::setValue(BasicProperty p, const QVariant &value)
+{
+    switch (p) {
+    case BasicProperty::ContentType:
+        setContentType(value.toString());
+        break;
+    case BasicProperty::ContentEncoding:
+        setContentEncoding(value.toString());
+        break;
+    case BasicProperty::Headers:
+        setHeaders(value.toHash());
+        break;
+    case BasicProperty::DeliveryMode:
+        setDeliveryMode(value.value<quint8>());
+        break;
+    case BasicProperty::Priority:
+        setPriority(value.value<quint8>());
+        break;
+    case BasicProperty::CorrelationId:
+        setCorrelationId(value.toString());
+        break;
+    case BasicProperty::ReplyTo:
+        setReplyTo(value.toString());
+        break;
+    case BasicProperty::Expiration:
+        setExpiration(value.toString());
+        break;
+    case BasicProperty::MessageId:
+        setMessageId(value.toString());
+        break;
+    case BasicProperty::Timestamp:
+        setTimestamp(value.toDateTime());
+        break;
+    case BasicProperty::Type:
+        setType(value.toString());
+        break;
+    case BasicProperty::UserId:
+        setUserId(value.toString());
+        break;
+    case BasicProperty::AppId:
+        setAppId(value.toString());
+        break;
+    case BasicProperty::_ClusterId:
+        set(&m_clusterId, value.toString(), p);
+        break;
+    default:
+        qWarning() << "Unknown basic property" << (int) p;
+        break;
+    }
+}
+
+bool BasicProperties::operator==(const BasicProperties &other) const
+{
+    // Absent properties always hold their default value, so members can be compared directly.
+    return m_flags == other.m_flags && m_deliveryMode == other.m_deliveryMode
+           && m_priority == other.m_priority && m_timestamp == other.m_timestamp
+           && m_contentType == other.m_contentType && m_contentEncoding == other.m_contentEncoding
+           && m_correlationId == other.m_correlationId && m_replyTo == other.m_replyTo
+           && m_expiration == other.m_expiration && m_messageId == other.m_messageId
+           && m_type == other.m_type && m_userId == other.m_userId && m_appId == other.m_appId
+           && m_clusterId == other.m_clusterId && m_headers == other.m_headers;
+}
+
+namespace detail {
+
+bool writeBasicProperties(ByteWriter *out, const BasicProperties &props)
+{
+    const quint16 flags = props.flags();
+    writeValue<quint16>(out, flags);
+    bool ok = true;
+    if (flags & BasicProperties::flag(BasicProperty::ContentType)) {
+        ok = writeShortStr(out, props.contentType()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::ContentEncoding)) {
+        ok = writeShortStr(out, props.contentEncoding()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Headers)) {
+        ok = writeTable(out, props.headers()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::DeliveryMode)) {
+        writeValue<quint8>(out, props.deliveryMode());
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Priority)) {
+        writeValue<quint8>(out, props.priority());
+    }
+    if (flags & BasicProperties::flag(BasicProperty::CorrelationId)) {
+        ok = writeShortStr(out, props.correlationId()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::ReplyTo)) {
+        ok = writeShortStr(out, props.replyTo()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Expiration)) {
+        ok = writeShortStr(out, props.expiration()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::MessageId)) {
+        ok = writeShortStr(out, props.messageId()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Timestamp)) {
+        writeValue<qint64>(out, props.timestampSecs());
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Type)) {
+        ok = writeShortStr(out, props.type()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::UserId)) {
+        ok = writeShortStr(out, props.userId()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::AppId)) {
+        ok = writeShortStr(out, props.appId()) && ok;
+    }
+    if (flags & BasicProperties::flag(BasicProperty::_ClusterId)) {
+        ok = writeShortStr(out, props.clusterId()) && ok;
+    }
+    return ok;
+}
+
+bool readBasicProperties(ByteCursor *in, BasicProperties *props)
+{
+    bool ok = true;
+    const quint16 flags = readValue<quint16>(in, &ok);
+    if (!ok) {
+        return false;
+    }
+    if ((flags & ~basicPropertyMask) != 0) {
+        // The low bits are the continuation flag and would be followed by more flag words,
+        // which no basic property uses.
+        qWarning() << "Unexpected basic property flags" << Qt::hex << flags;
+    }
+    BasicProperties result;
+    if (flags & BasicProperties::flag(BasicProperty::ContentType)) {
+        result.setContentType(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::ContentEncoding)) {
+        result.setContentEncoding(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Headers)) {
+        result.setHeaders(readTable(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::DeliveryMode)) {
+        result.setDeliveryMode(readValue<quint8>(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Priority)) {
+        result.setPriority(readValue<quint8>(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::CorrelationId)) {
+        result.setCorrelationId(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::ReplyTo)) {
+        result.setReplyTo(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Expiration)) {
+        result.setExpiration(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::MessageId)) {
+        result.setMessageId(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Timestamp)) {
+        result.setTimestampSecs(readValue<qint64>(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::Type)) {
+        result.setType(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::UserId)) {
+        result.setUserId(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::AppId)) {
+        result.setAppId(readShortStr(in, &ok));
+    }
+    if (flags & BasicProperties::flag(BasicProperty::_ClusterId)) {
+        result.setValue(BasicProperty::_ClusterId, readShortStr(in, &ok));
+    }
+    if (!ok) {
+        qWarning() << "Failed to read basic properties";
+        return false;
+    }
+    *props = result;
+    return true;
+}
+
+} // namespace detail
+} // namespace qmq
+
+QDebug operator<<(QDebug debug, const qmq::BasicProperties &properties)
+{
+    QDebugStateSaver saver(debug);
+    debug.nospace() << "qmq::BasicProperties(";
+    bool first = true;
+    for (int i = 0; i < qmq::basicPropertyCount; ++i) {
+        const qmq::BasicProperty p = static_cast<qmq::BasicProperty>(i);
+        if (!properties.contains(p)) {
+            continue;
+        }
+        if (!first) {
+            debug << ", ";
+        }
+        first = false;
+        debug << qmq::basicPropertyName(p) << "=" << properties.value(p);
+    }
+    debug << ")";
+    return debug;
+}
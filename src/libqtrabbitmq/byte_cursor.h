@@ -0,0 +1,81 @@
+#pragma once
+
+#include <qtrabbitmq/byte_view.h>
+
+#include <QByteArray>
+#include <qglobal.h>
+
+#include <cstring>
+
+namespace qmq::detail {
+
+//! Sequential reader over a contiguous, in-memory byte range.
+//!
+//! Offers the subset of the QIODevice read interface used by the frame decoder
+//! (read(char*, n), read(n), atEnd(), bytesAvailable()) without virtual calls
+//! or heap allocation, so that the decoder templates can parse frames in place.
+class ByteCursor
+{
+public:
+    ByteCursor(const char *data, qsizetype size)
+        : m_pos(data)
+        , m_end(data + size)
+    {}
+    explicit ByteCursor(const QByteArray &data)
+        : ByteCursor(data.constData(), data.size())
+    {}
+    explicit ByteCursor(const ByteView &view)
+        : ByteCursor(view.data(), view.size())
+    {}
+
+    bool atEnd() const { return m_pos >= m_end; }
+    qint64 bytesAvailable() const { return m_end - m_pos; }
+    const char *current() const { return m_pos; }
+
+    qint64 read(char *dest, qint64 len)
+    {
+        if (len > bytesAvailable()) {
+            return -1;
+        }
+        std::memcpy(dest, m_pos, static_cast<size_t>(len));
+        m_pos += len;
+        return len;
+    }
+
+    //! Copying read, for values that outlive the buffer (strings etc.).
+    QByteArray read(qint64 len)
+    {
+        if (len > bytesAvailable()) {
+            return QByteArray();
+        }
+        const QByteArray result(m_pos, static_cast<qsizetype>(len));
+        m_pos += len;
+        return result;
+    }
+
+    bool skip(qint64 len)
+    {
+        if (len > bytesAvailable()) {
+            return false;
+        }
+        m_pos += len;
+        return true;
+    }
+
+    //! Splits off the next \a len bytes as an independent cursor and advances past them.
+    bool subCursor(qint64 len, ByteCursor *sub)
+    {
+        if (len > bytesAvailable()) {
+            return false;
+        }
+        *sub = ByteCursor(m_pos, static_cast<qsizetype>(len));
+        m_pos += len;
+        return true;
+    }
+
+private:
+    const char *m_pos = nullptr;
+    const char *m_end = nullptr;
+};
+
+} // namespace qmq::detail
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtEndian>
+#include <qglobal.h>
+
+namespace qmq::detail {
+
+//! Sequential writer appending to a QByteArray.
+//!
+//! Counterpart of ByteCursor: offers the write(char*, n) / write(QByteArray) subset of
+//! QIODevice used by the frame encoder, without the virtual calls of a QBuffer.
+class ByteWriter
+{
+public:
+    explicit ByteWriter(QByteArray *out)
+        : m_out(out)
+    {}
+
+    qint64 write(const char *data, qint64 len)
+    {
+        m_out->append(data, static_cast<qsizetype>(len));
+        return len;
+    }
+    qint64 write(const QByteArray &data)
+    {
+        m_out->append(data);
+        return data.size();
+    }
+
+    qsizetype size() const { return m_out->size(); }
+    //! Drops everything written after size() returned \a pos.
+    void truncate(qsizetype pos) { m_out->truncate(pos); }
+
+    //! Overwrites a big-endian value written earlier, e.g. a length reserved before its content.
+    template<typename T>
+    void patch(qsizetype pos, T value)
+    {
+        qToBigEndian<T>(value, m_out->data() + pos);
+    }
+
+    QByteArray *buffer() const { return m_out; }
+
+private:
+    QByteArray *m_out = nullptr;
+};
+
+} // namespace qmq::detail
@@ -1,21 +1,24 @@
+#include "client_p.h"
+#include "confirm_tracker.h"
+#include "rpc_tracker.h"
 #include "spec_constants.h"
+#include "spec_methods.h"
+#include "topology_cache.h"
+#include <qtrabbitmq/ack_batcher.h>
 #include <qtrabbitmq/channel.h>
 #include <qtrabbitmq/client.h>
 #include <qtrabbitmq/consumer.h>
 #include <qtrabbitmq/exception.h>
+#include <qtrabbitmq/publish_batch.h>
+#include <qtrabbitmq/topology.h>
 
 #include <QUuid>
 
+#include <type_traits>
+
 namespace {
 constexpr const quint64 MAX_MESSAGE_SIZE = 10 * 1024 * 1024;
 
-QDebug operator<<(QDebug debug, const QHash<qmq::BasicProperty, QVariant> &propHash)
-{
-    for (auto it(propHash.constBegin()); it != propHash.constEnd(); ++it) {
-        debug = (debug << qmq::basicPropertyName(it.key()) << it.value());
-    }
-    return debug;
-}
 QString exchangeTypeToString(qmq::Channel::ExchangeType exchType)
 {
     switch (exchType) {
@@ -33,41 +36,17 @@ QString exchangeTypeToString(qmq::Channel::ExchangeType exchType)
     }
 }
 
-class MessageItem
-{
-public:
-    MessageItem(quint16 cid, quint16 mid)
-        : classId(cid)
-        , methodId(mid)
-    {}
-    virtual ~MessageItem() = default;
-
-    virtual void start() = 0;
-    virtual void finish() = 0;
-    virtual void setException(const QException &) = 0;
-    quint16 classId = 0;
-    quint16 methodId = 0;
-};
-
+using MessageItem = qmq::detail::MessageItem;
 template<class T>
-class MessagePromise : public MessageItem
-{
-public:
-    MessagePromise(quint16 cid, quint16 mid)
-        : MessageItem(cid, mid)
-    {}
-    void start() override { promise.start(); };
-    void finish() override { promise.finish(); };
-    void setException(const QException &exc) override { promise.setException(exc); }
-
-    QPromise<T> promise;
-};
+using MessagePromise = qmq::detail::MessagePromise<T>;
 
 struct IncomingMessage
 {
-    QHash<qmq::BasicProperty, QVariant> m_properties;
+    qmq::BasicProperties m_properties;
     quint64 m_contentSize = 0;
+    // Bodies of several frames are put together here; m_body views the complete body.
     QByteArray m_payload;
+    qmq::ByteView m_body;
     QString m_consumerTag;
     quint64 m_deliveryTag = 0;
     bool m_redelivered = false;
@@ -83,13 +62,59 @@ using MessageVlistPtr = QSharedPointer<MessagePromise<QVariantList>>;
 using MessageIntPtr = QSharedPointer<MessagePromise<int>>;
 using MessageStrPtr = QSharedPointer<MessagePromise<QString>>;
 
+QFuture<void> readyFuture()
+{
+    QPromise<void> promise;
+    promise.start();
+    promise.finish();
+    return promise.future();
+}
+
+template<class T>
+QFuture<T> readyFuture(const T &value)
+{
+    QPromise<T> promise;
+    promise.start();
+    promise.addResult(value);
+    promise.finish();
+    return promise.future();
+}
+
+QFuture<void> failedFuture(int code, const QString &message)
+{
+    QPromise<void> promise;
+    promise.start();
+    promise.setException(qmq::Exception(code, message));
+    promise.finish();
+    return promise.future();
+}
+
+//! Calls \a fn with the error code and text once \a future finishes; code 0 on success.
+template<class T, class Fn>
+void whenSettled(QFuture<T> future, Fn fn)
+{
+    future.then([fn](QFuture<T> finished) {
+        try {
+            finished.waitForFinished();
+        } catch (const qmq::Exception &e) {
+            fn(e.code() != 0 ? e.code() : 1, QString::fromUtf8(e.what()));
+            return;
+        } catch (const std::exception &e) {
+            fn(1, QString::fromUtf8(e.what()));
+            return;
+        }
+        fn(0, QString());
+    });
+}
+
 template<class T>
 QSharedPointer<MessagePromise<T>> getPromise(MessageItemPtr &ptr)
 {
     if (!ptr) {
         return QSharedPointer<MessagePromise<T>>();
     }
-    return ptr.dynamicCast<MessagePromise<T>>();
+    // The request method fixes the promise type.
+    return ptr.staticCast<MessagePromise<T>>();
 }
 } // namespace
 
@@ -104,15 +129,160 @@ public:
 
     MessageItemPtr popFirstMessageItem(qint16 classId, qint16 methodId)
     {
-        for (auto it = inFlightMessages.begin(); it != inFlightMessages.end(); ++it) {
-            const MessageItemPtr ptr = *it;
-            if (ptr->methodId == methodId && ptr->classId == classId) {
-                inFlightMessages.erase(it);
-                return *it;
+        return inFlightMessages.take(quint16(classId), quint16(methodId));
+    }
+
+    detail::TopologyCache *topologyCache() { return &Client::Private::get(client)->topologyCache; }
+
+    //! Remembers the declaration \a key once \a future succeeds. Any failed declaration
+    //! clears the cache, since the broker's view may differ from it.
+    template<class T>
+    void cacheDeclare(const QFuture<T> &future, const QByteArray &key)
+    {
+        if (key.isEmpty()) {
+            return;
+        }
+        const QPointer<Client> guard(client);
+        QFuture<T>(future).then([guard, key](QFuture<T> finished) {
+            if (!guard) {
+                return;
             }
+            detail::TopologyCache &cache = Client::Private::get(guard.data())->topologyCache;
+            try {
+                finished.waitForFinished();
+            } catch (...) {
+                cache.clear();
+                return;
+            }
+            if constexpr (std::is_same_v<T, QVariantList>) {
+                cache.insert(key, finished.resultCount() > 0 ? finished.result() : QVariantList());
+            } else {
+                cache.insert(key);
+            }
+        });
+    }
+
+    //! Tracks a request until its reply arrives or the RPC timeout passes.
+    void trackRpc(const MessageItemPtr &item)
+    {
+        inFlightMessages.add(item, rpcTimeoutMs >= 0 ? rpcTimeoutMs : client->rpcTimeoutMs());
+    }
+
+    //! Appends basic.publish, the content header and the body frames of \a message to \a writer,
+    //! so that they reach the socket in one write. Nothing is appended if any of them fails.
+    bool writePublish(detail::FrameWriter *writer, const Message &message, PublishOptions opts)
+    {
+        spec::methods::basic::Publish method;
+        method.exchange = message.exchangeName();
+        method.routingKey = message.routingKey();
+        method.mandatory = opts.testFlag(PublishOption::Mandatory);
+        method.immediate = opts.testFlag(PublishOption::Immediate);
+
+        writer->setMaxFrameSize(client->maxFrameSizeBytes());
+        const qsizetype mark = writer->size();
+        if (!writer->writeMethod(channelId, method)
+            || !writer->writeContent(channelId,
+                                     method.ClassId,
+                                     message.basicProperties(),
+                                     message.payload())) {
+            writer->rollback(mark);
+            return false;
         }
-        qWarning() << "No message found for classID" << classId << methodId;
-        return {};
+        return true;
+    }
+
+    //! Numbers \a count publishes that were just sent, when in confirm mode.
+    void publishesSent(qsizetype count)
+    {
+        if (confirms.isEnabled()) {
+            confirms.addPublishes(count);
+        }
+    }
+
+    //! Commands are held while the channel waits for channel.open-ok, or in eager mode until
+    //! channel.open and the commands behind it are released together. They are also held from
+    //! a gated publish until the connection is unblocked, so that they keep their order.
+    bool isHoldingFrames() const
+    {
+        return blockedHold
+               || (state == Channel::ChannelState::Opening
+                   && (!eagerPipelining || releaseScheduled));
+    }
+
+    //! Called before a publish: on a blocked connection with publish gating, starts holding.
+    void holdIfBlocked()
+    {
+        if (!blockedHold && Client::Private::get(client)->isPublishGated()) {
+            blockedHold = true;
+        }
+    }
+
+    //! Counts frames held since the last call towards the client's gated publish limit.
+    void countHeldFrames()
+    {
+        if (blockedHold) {
+            Client::Private::get(client)->gatedBytes += heldFrames.size() - countedHeldBytes;
+            countedHeldBytes = heldFrames.size();
+        }
+    }
+
+    void uncountHeldFrames()
+    {
+        Client::Private::get(client)->gatedBytes -= countedHeldBytes;
+        countedHeldBytes = 0;
+    }
+
+    void releaseBlockedFrames()
+    {
+        if (!blockedHold) {
+            return;
+        }
+        blockedHold = false;
+        uncountHeldFrames();
+        if (!isHoldingFrames()) {
+            releaseHeldFrames();
+        }
+    }
+
+    //! Where the frames of a command go: the held frames, or the client's writer.
+    detail::FrameWriter *frameWriter()
+    {
+        return isHoldingFrames() ? &heldFrames : &Client::Private::get(client)->writer;
+    }
+
+    bool sendFrame(const Frame &frame)
+    {
+        if (!isHoldingFrames()) {
+            return client->sendFrame(frame);
+        }
+        heldFrames.setMaxFrameSize(client->maxFrameSizeBytes());
+        const bool isOk = heldFrames.writeFrame(frame);
+        countHeldFrames();
+        return isOk;
+    }
+
+    //! Commits the frames just written to frameWriter().
+    bool commitFrames()
+    {
+        if (isHoldingFrames()) {
+            countHeldFrames();
+            return true;
+        }
+        return Client::Private::get(client)->commitFrames();
+    }
+
+    //! Hands the held frames to the client in one piece.
+    bool releaseHeldFrames()
+    {
+        releaseScheduled = false;
+        uncountHeldFrames();
+        if (heldFrames.isEmpty()) {
+            return true;
+        }
+        Client::Private *clientPrivate = Client::Private::get(client);
+        clientPrivate->writer.writeEncoded(heldFrames.buffer());
+        heldFrames.clear();
+        return clientPrivate->commitFrames();
     }
 
     void changeState(Channel::ChannelState newState)
@@ -126,10 +296,18 @@ public:
     Channel *const q;
     quint16 channelId = 0;
     Client *client = nullptr;
-    QList<MessageItemPtr> inFlightMessages;
+    detail::RpcTracker inFlightMessages;
+    int rpcTimeoutMs = -1;
     QScopedPointer<IncomingMessage> deliveringMessage;
     QHash<QString, QPointer<Consumer>> consumers;
     Channel::ChannelState state = Channel::ChannelState::Closed;
+    detail::ConfirmTracker confirms;
+    QPointer<AckBatcher> ackBatcher;
+    detail::FrameWriter heldFrames;
+    bool eagerPipelining = false;
+    bool releaseScheduled = false;
+    bool blockedHold = false;
+    qsizetype countedHeldBytes = 0;
 };
 
 Channel::Channel(Client *client, quint16 channelId)
@@ -137,6 +315,10 @@ Channel::Channel(Client *client, quint16 channelId)
 {
     d->channelId = channelId;
     d->client = client;
+    if (client) {
+        d->inFlightMessages.setTimerWheel(&Client::Private::get(client)->timers);
+        connect(client, &Client::unblocked, this, [this]() { d->releaseBlockedFrames(); });
+    }
 }
 
 Channel::~Channel() = default;
@@ -146,6 +328,16 @@ int Channel::channelId() const
     return d->channelId;
 }
 
+int Channel::rpcTimeoutMs() const
+{
+    return d->rpcTimeoutMs;
+}
+
+void Channel::setRpcTimeoutMs(int ms)
+{
+    d->rpcTimeoutMs = ms;
+}
+
 bool Channel::handleMethodFrame(const MethodFrame &frame)
 {
     Q_ASSERT(frame.channel() == this->channelId());
@@ -173,6 +365,10 @@ bool Channel::handleMethodFrame(const MethodFrame &frame)
             return this->onExchangeDeclareOk(frame);
         case qmq::spec::exchange::DeleteOk:
             return this->onExchangeDeleteOk(frame);
+        case qmq::spec::exchange::BindOk:
+            return this->onExchangeBindOk(frame);
+        case qmq::spec::exchange::UnbindOk:
+            return this->onExchangeUnbindOk(frame);
         default:
             qWarning() << "Unknown exchange frame" << frame.methodId();
             break;
@@ -213,11 +409,24 @@ bool Channel::handleMethodFrame(const MethodFrame &frame)
             return this->onBasicGetEmpty(frame);
         case qmq::spec::basic::RecoverOk:
             return this->onBasicRecoverOk(frame);
+        case qmq::spec::basic::Ack:
+            return this->onBasicAck(frame);
+        case qmq::spec::basic::Nack:
+            return this->onBasicNack(frame);
         default:
             qWarning() << "Unknown basic frame" << frame.methodId();
             break;
         }
         break;
+    case qmq::spec::confirm::ID_:
+        switch (frame.methodId()) {
+        case qmq::spec::confirm::SelectOk:
+            return this->onConfirmSelectOk(frame);
+        default:
+            qWarning() << "Unknown confirm frame" << frame.methodId();
+            break;
+        }
+        break;
     case qmq::spec::tx::ID_:
         switch (frame.methodId()) {
         case qmq::spec::tx::SelectOk:
@@ -245,16 +454,15 @@ bool Channel::handleHeaderFrame(const HeaderFrame &frame)
         return false;
     }
 
-    qDebug() << "Header with properties" << frame.properties();
+    qDebug() << "Header with properties" << frame.basicProperties();
     const quint64 messageSize = frame.contentSize();
     if (messageSize > MAX_MESSAGE_SIZE) {
         qWarning() << "Frame too large" << messageSize;
         this->channelClose(500, "Message too large");
         return false;
     }
-    d->deliveringMessage->m_properties = frame.properties();
+    d->deliveringMessage->m_properties = frame.basicProperties();
     d->deliveringMessage->m_contentSize = frame.contentSize();
-    d->deliveringMessage->m_payload.reserve(static_cast<qsizetype>(messageSize));
     if (messageSize == 0) {
         this->incomingMessageComplete();
     }
@@ -263,16 +471,28 @@ bool Channel::handleHeaderFrame(const HeaderFrame &frame)
 
 bool Channel::handleBodyFrame(const BodyFrame &frame)
 {
-    qDebug() << "Body frame with" << frame.content().size() << "bytes";
+    const ByteView &body = frame.bodyView();
+    qDebug() << "Body frame with" << body.size() << "bytes";
     if (!d->deliveringMessage) {
         qWarning() << "Body frame unexpected";
         return false;
     }
-    d->deliveringMessage->m_payload.append(frame.content());
-    if (static_cast<quint64>(d->deliveringMessage->m_payload.size())
-        >= d->deliveringMessage->m_contentSize) {
-        this->incomingMessageComplete();
+    IncomingMessage *incoming = d->deliveringMessage.get();
+    if (incoming->m_payload.isEmpty()
+        && static_cast<quint64>(body.size()) >= incoming->m_contentSize) {
+        // The whole body in one frame, the common case: it stays in the receive buffer.
+        incoming->m_body = body;
+    } else {
+        if (incoming->m_payload.isEmpty()) {
+            incoming->m_payload.reserve(static_cast<qsizetype>(incoming->m_contentSize));
+        }
+        incoming->m_payload.append(body.data(), body.size());
+        if (static_cast<quint64>(incoming->m_payload.size()) < incoming->m_contentSize) {
+            return true;
+        }
+        incoming->m_body = ByteView(incoming->m_payload);
     }
+    this->incomingMessageComplete();
     return true;
 }
 
@@ -293,21 +513,40 @@ bool Channel::addConsumer(Consumer *consumer)
 // Channel methods
 QFuture<void> Channel::channelOpen()
 {
-    MethodFrame frame(d->channelId, spec::channel::ID_, spec::channel::Open);
+    const MethodFrame frame = detail::encodeMethod(d->channelId, spec::methods::channel::Open());
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->promise.start();
-    const QString reserved1; // out-of-band
-    const QVariantList args({reserved1});
-    qDebug() << "Set open channel method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    d->changeState(ChannelState::Opening);
+    qDebug() << "Set open channel method" << d->channelId;
 
-    bool isOk = d->client->sendFrame(frame);
+    bool isOk = false;
+    if (d->eagerPipelining) {
+        // channel.open leads the held frames; they all go out once control returns to the
+        // event loop.
+        d->heldFrames.setMaxFrameSize(d->client->maxFrameSizeBytes());
+        isOk = d->heldFrames.writeFrame(frame);
+        if (isOk && !d->releaseScheduled) {
+            d->releaseScheduled = true;
+            QMetaObject::invokeMethod(
+                this,
+                [this]() {
+                    if (d->releaseScheduled && !d->blockedHold) {
+                        d->releaseHeldFrames();
+                    }
+                },
+                Qt::QueuedConnection);
+        }
+    } else {
+        isOk = d->client->sendFrame(frame);
+    }
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
         messageTracker->finish();
+        d->heldFrames.clear();
+        d->releaseScheduled = false;
+        d->changeState(ChannelState::Closed);
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->changeState(ChannelState::Opening);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -319,48 +558,69 @@ bool Channel::onChannelOpenOk(const MethodFrame &frame)
     MessageItemPtr messageTracker(d->popFirstMessageItem(spec::channel::ID_, spec::channel::Open));
 
     qDebug() << "channel::OpenOk";
+    if (d->state == ChannelState::Opening) {
+        // Commands issued meanwhile go out before anything the open continuations send; while
+        // the connection is blocked they wait for it to be unblocked.
+        if (!d->blockedHold) {
+            d->releaseHeldFrames();
+        }
+        d->changeState(ChannelState::Open);
+    }
     if (messageTracker) {
         messageTracker->finish();
     }
-    d->changeState(ChannelState::Open);
     return true;
 }
 
+bool Channel::isEagerPipelining() const
+{
+    return d->eagerPipelining;
+}
+
+void Channel::setEagerPipelining(bool eager)
+{
+    d->eagerPipelining = eager;
+}
+
+Channel::ChannelState Channel::channelState() const
+{
+    return d->state;
+}
+
 QFuture<void> Channel::channelFlow(bool active)
 {
-    MethodFrame frame(d->channelId, spec::channel::ID_, spec::channel::Flow);
+    spec::methods::channel::Flow method;
+    method.active = active;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->promise.start();
-    const QVariantList args = {active};
-    qDebug() << "Set channel flow method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set channel flow method" << d->channelId << "active" << active;
+    bool isOk = d->sendFrame(frame);
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
 
 bool Channel::onChannelFlow(const MethodFrame &frame)
 {
-    bool isOk(false);
-    const QVariantList args(frame.getArguments(&isOk));
-    const bool active = args.at(0).toBool();
-    isOk = this->channelFlowOk(active);
-
-    return isOk;
+    spec::methods::channel::Flow method;
+    if (!detail::decodeMethod(frame, &method)) {
+        return false;
+    }
+    return this->channelFlowOk(method.active);
 }
 
 bool Channel::channelFlowOk(bool active)
 {
-    MethodFrame frame(d->channelId, spec::channel::ID_, spec::channel::FlowOk);
-    const QVariantList args = {active};
-    qDebug() << "Set channel flow method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+    spec::methods::channel::FlowOk method;
+    method.active = active;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
+    qDebug() << "Set channel flow-ok method" << d->channelId << "active" << active;
+    const bool isOk = d->sendFrame(frame);
     return isOk;
 }
 
@@ -382,22 +642,29 @@ QFuture<void> Channel::channelClose(quint16 code,
 {
     MessageItemVoidPtr messageTracker(
         new MessagePromise<void>(spec::channel::ID_, spec::channel::Close));
-    const QVariantList args({QVariant::fromValue(code),
-                             replyText,
-                             QVariant::fromValue(classId),
-                             QVariant::fromValue(methodId)});
-    MethodFrame frame(d->channelId, spec::channel::ID_, spec::channel::Close);
-
+    spec::methods::channel::Close method;
+    method.replyCode = code;
+    method.replyText = replyText;
+    method.classId = classId;
+    method.methodId = methodId;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
+
+    if (d->releaseScheduled || d->blockedHold) {
+        // channel.open or gated publishes have not been written yet.
+        d->blockedHold = false;
+        d->releaseHeldFrames();
+    } else {
+        d->heldFrames.clear();
+    }
     d->changeState(ChannelState::Closing);
-    qDebug() << "Set channel.close frame args" << args;
-    frame.setArguments(args);
+    qDebug() << "Set channel.close frame" << code << replyText;
     messageTracker->promise.start();
     if (!d->client->sendFrame(frame)) {
         messageTracker->setException(qmq::Exception(1, "Failed to send close frame"));
         messageTracker->finish();
         d->changeState(ChannelState::Closed);
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -419,13 +686,14 @@ bool Channel::onChannelCloseOk(const MethodFrame &frame)
 bool Channel::onChannelClose(const MethodFrame &frame)
 {
     qDebug() << "Close received";
-    const QVariantList args = frame.getArguments();
-    const quint16 code = args.at(0).value<quint16>();
-    const QString replyText = args.at(1).toString();
-    const quint16 classId = args.at(2).value<quint16>();
-    const quint16 methodId = args.at(3).value<quint16>();
-    qDebug() << "Code:" << code << "replyText:" << replyText << "class, method: (" << classId << ","
-             << methodId << ")";
+    spec::methods::channel::Close method;
+    if (!detail::decodeMethod(frame, &method)) {
+        qWarning() << "Failed to get arguments";
+    }
+    qDebug() << "Code:" << method.replyCode << "replyText:" << method.replyText
+             << "class, method: (" << method.classId << "," << method.methodId << ")";
+    // Fail pending requests with the broker's reason rather than a generic one.
+    this->emptyMessageTracking(method.replyCode, method.replyText);
     return this->channelCloseOk();
 }
 
@@ -448,34 +716,44 @@ QFuture<void> Channel::exchangeDeclare(const QString &exchangeName,
                                        ExchangeDeclareOptions opts,
                                        const QVariantHash &arguments)
 {
+    QByteArray cacheKey;
+    if (!opts.testFlag(ExchangeDeclareOption::Passive)
+        && !opts.testFlag(ExchangeDeclareOption::NoWait)) {
+        cacheKey = detail::TopologyCache::key(detail::TopologyCache::Kind::Exchange,
+                                              exchangeName,
+                                              exchangeTypeToString(type),
+                                              QString(),
+                                              int(opts),
+                                              arguments);
+        if (d->topologyCache()->find(cacheKey)) {
+            return readyFuture();
+        }
+    }
+
     MessageItemVoidPtr messageTracker(
         new MessagePromise<void>(spec::exchange::ID_, spec::exchange::Declare));
-    MethodFrame frame(d->channelId, spec::exchange::ID_, spec::exchange::Declare);
     messageTracker->start();
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const QString exchangeType = exchangeTypeToString(type);
-    const bool reserved2 = false;
-    const bool reserved3 = false;
-
-    QVariantList args({reserved1,
-                       exchangeName,
-                       exchangeType,
-                       opts.testFlag(ExchangeDeclareOption::Passive),
-                       opts.testFlag(ExchangeDeclareOption::Durable),
-                       reserved2,
-                       reserved3,
-                       opts.testFlag(ExchangeDeclareOption::NoWait),
-                       arguments});
-    qDebug() << "Set declare exchange method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+
+    spec::methods::exchange::Declare method;
+    method.exchange = exchangeName;
+    method.type = exchangeTypeToString(type);
+    method.passive = opts.testFlag(ExchangeDeclareOption::Passive);
+    method.durable = opts.testFlag(ExchangeDeclareOption::Durable);
+    method.autoDelete = opts.testFlag(ExchangeDeclareOption::AutoDelete);
+    method.internal = opts.testFlag(ExchangeDeclareOption::Internal);
+    method.noWait = opts.testFlag(ExchangeDeclareOption::NoWait);
+    method.arguments = arguments;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
+    qDebug() << "Set declare exchange method" << d->channelId << exchangeName << method.type;
+    bool isOk = d->sendFrame(frame);
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
         messageTracker->finish();
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
+    d->cacheDeclare(messageTracker->promise.future(), cacheKey);
 
     return messageTracker->promise.future();
 }
@@ -495,17 +773,17 @@ bool Channel::onExchangeDeclareOk(const MethodFrame &frame)
 
 QFuture<void> Channel::exchangeDelete(const QString &exchangeName, ExchangeDeleteOptions opts)
 {
-    MethodFrame frame(d->channelId, spec::exchange::ID_, spec::exchange::Delete);
+    d->topologyCache()->clear();
+    spec::methods::exchange::Delete method;
+    method.exchange = exchangeName;
+    method.ifUnused = opts.testFlag(ExchangeDeleteOption::IfUnused);
+    method.noWait = opts.testFlag(ExchangeDeleteOption::NoWait);
+    const bool noWait = method.noWait;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const bool ifUnused = opts.testFlag(ExchangeDeleteOption::IfUnused);
-    const bool noWait = opts.testFlag(ExchangeDeleteOption::NoWait);
-    const QVariantList args({reserved1, exchangeName, ifUnused, noWait});
-    qDebug() << "Set delete exchange method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set delete exchange method" << d->channelId << exchangeName;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -516,7 +794,7 @@ QFuture<void> Channel::exchangeDelete(const QString &exchangeName, ExchangeDelet
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -540,16 +818,31 @@ QFuture<void> Channel::exchangeBind(const QString &exchangeNameDestination,
                                     bool noWait,
                                     const QVariantHash &arguments)
 {
-    MethodFrame frame(d->channelId, spec::exchange::ID_, spec::exchange::Bind);
+    QByteArray cacheKey;
+    if (!noWait) {
+        cacheKey = detail::TopologyCache::key(detail::TopologyCache::Kind::ExchangeBinding,
+                                              exchangeNameDestination,
+                                              exchangeNameSource,
+                                              routingKey,
+                                              0,
+                                              arguments);
+        if (d->topologyCache()->find(cacheKey)) {
+            return readyFuture();
+        }
+    }
+
+    spec::methods::exchange::Bind method;
+    method.destination = exchangeNameDestination;
+    method.source = exchangeNameSource;
+    method.routingKey = routingKey;
+    method.noWait = noWait;
+    method.arguments = arguments;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-
-    const QVariantList args(
-        {reserved1, exchangeNameDestination, exchangeNameSource, routingKey, noWait, arguments});
-    qDebug() << "Set bind exchange method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set bind exchange method" << d->channelId << exchangeNameDestination
+             << exchangeNameSource << routingKey;
+    bool isOk = d->sendFrame(frame);
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
         messageTracker->finish();
@@ -559,7 +852,8 @@ QFuture<void> Channel::exchangeBind(const QString &exchangeNameDestination,
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
+        d->cacheDeclare(messageTracker->promise.future(), cacheKey);
     }
     return messageTracker->promise.future();
 }
@@ -582,16 +876,19 @@ QFuture<void> Channel::exchangeUnbind(const QString &exchangeNameDestination,
                                       bool noWait,
                                       const QVariantHash &arguments)
 {
-    MethodFrame frame(d->channelId, spec::exchange::ID_, spec::exchange::Unbind);
+    d->topologyCache()->clear();
+    spec::methods::exchange::Unbind method;
+    method.destination = exchangeNameDestination;
+    method.source = exchangeNameSource;
+    method.routingKey = routingKey;
+    method.noWait = noWait;
+    method.arguments = arguments;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-
-    const QVariantList args(
-        {reserved1, exchangeNameDestination, exchangeNameSource, routingKey, noWait, arguments});
-    qDebug() << "Set bind exchange method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set unbind exchange method" << d->channelId << exchangeNameDestination
+             << exchangeNameSource << routingKey;
+    bool isOk = d->sendFrame(frame);
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
         messageTracker->finish();
@@ -601,7 +898,7 @@ QFuture<void> Channel::exchangeUnbind(const QString &exchangeNameDestination,
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -625,23 +922,37 @@ QFuture<QVariantList> Channel::queueDeclare(const QString &queueName,
                                             QueueDeclareOptions opts,
                                             const QVariantHash &arguments)
 {
-    MethodFrame frame(d->channelId, spec::queue::ID_, spec::queue::Declare);
+    // Server-named, auto-delete and expiring queues can be gone by the next declare.
+    QByteArray cacheKey;
+    if (!queueName.isEmpty() && !opts.testFlag(QueueDeclareOption::Passive)
+        && !opts.testFlag(QueueDeclareOption::NoWait)
+        && !opts.testFlag(QueueDeclareOption::AutoDelete)
+        && !arguments.contains(QStringLiteral("x-expires"))) {
+        cacheKey = detail::TopologyCache::key(detail::TopologyCache::Kind::Queue,
+                                              queueName,
+                                              QString(),
+                                              QString(),
+                                              int(opts),
+                                              arguments);
+        if (const QVariantList *reply = d->topologyCache()->find(cacheKey)) {
+            return readyFuture(*reply);
+        }
+    }
+
+    spec::methods::queue::Declare method;
+    method.queue = queueName;
+    method.passive = opts.testFlag(QueueDeclareOption::Passive);
+    method.durable = opts.testFlag(QueueDeclareOption::Durable);
+    method.exclusive = opts.testFlag(QueueDeclareOption::Exclusive);
+    method.autoDelete = opts.testFlag(QueueDeclareOption::AutoDelete);
+    method.noWait = opts.testFlag(QueueDeclareOption::NoWait);
+    method.arguments = arguments;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageVlistPtr messageTracker(
         new MessagePromise<QVariantList>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const QVariantList args({reserved1,
-                             queueName,
-                             opts.testFlag(QueueDeclareOption::Passive),
-                             opts.testFlag(QueueDeclareOption::Durable),
-                             opts.testFlag(QueueDeclareOption::Exclusive),
-                             opts.testFlag(QueueDeclareOption::AutoDelete),
-                             opts.testFlag(QueueDeclareOption::NoWait),
-                             arguments});
-    qDebug() << "Set declare queue method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set declare queue method" << d->channelId << queueName;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->promise.setException(qmq::Exception(1, "Failed to send frame"));
@@ -649,7 +960,8 @@ QFuture<QVariantList> Channel::queueDeclare(const QString &queueName,
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
+    d->cacheDeclare(messageTracker->promise.future(), cacheKey);
 
     return messageTracker->promise.future();
 }
@@ -659,11 +971,17 @@ bool Channel::onQueueDeclareOk(const MethodFrame &frame)
     qDebug() << "Declare Queue OK received";
     MessageItemPtr messageTracker(d->popFirstMessageItem(spec::queue::ID_, spec::queue::Declare));
     MessageVlistPtr trackedPromise(getPromise<QVariantList>(messageTracker));
-    const QVariantList args = frame.getArguments();
-    qDebug() << "Name, messageCount, consumerCount" << args;
+    spec::methods::queue::DeclareOk method;
+    if (!detail::decodeMethod(frame, &method)) {
+        qWarning() << "Failed to get arguments";
+    }
+    qDebug() << "Name, messageCount, consumerCount" << method.queue << method.messageCount
+             << method.consumerCount;
     if (messageTracker) {
         if (trackedPromise) {
-            trackedPromise->promise.addResult(args);
+            trackedPromise->promise.addResult({method.queue,
+                                               QVariant::fromValue(method.messageCount),
+                                               QVariant::fromValue(method.consumerCount)});
         }
         messageTracker->finish();
     }
@@ -676,15 +994,30 @@ QFuture<void> Channel::queueBind(const QString &queueName,
                                  bool noWait,
                                  const QVariantHash &arguments)
 {
-    MethodFrame frame(d->channelId, spec::queue::ID_, spec::queue::Bind);
+    QByteArray cacheKey;
+    if (!noWait) {
+        cacheKey = detail::TopologyCache::key(detail::TopologyCache::Kind::QueueBinding,
+                                              queueName,
+                                              exchangeName,
+                                              routingKey,
+                                              0,
+                                              arguments);
+        if (d->topologyCache()->find(cacheKey)) {
+            return readyFuture();
+        }
+    }
+
+    spec::methods::queue::Bind method;
+    method.queue = queueName;
+    method.exchange = exchangeName;
+    method.routingKey = routingKey;
+    method.noWait = noWait;
+    method.arguments = arguments;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const QVariantList args({reserved1, queueName, exchangeName, routingKey, noWait, arguments});
-    qDebug() << "Set bind queue method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set bind queue method" << d->channelId << queueName << exchangeName << routingKey;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -695,7 +1028,8 @@ QFuture<void> Channel::queueBind(const QString &queueName,
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
+        d->cacheDeclare(messageTracker->promise.future(), cacheKey);
     }
     return messageTracker->promise.future();
 }
@@ -716,15 +1050,18 @@ QFuture<void> Channel::queueUnbind(const QString &queueName,
                                    const QString &routingKey,
                                    const QVariantHash &arguments)
 {
-    MethodFrame frame(d->channelId, spec::queue::ID_, spec::queue::Unbind);
+    d->topologyCache()->clear();
+    spec::methods::queue::Unbind method;
+    method.queue = queueName;
+    method.exchange = exchangeName;
+    method.routingKey = routingKey;
+    method.arguments = arguments;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const QVariantList args({reserved1, queueName, exchangeName, routingKey, arguments});
-    qDebug() << "Set bind queue method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set unbind queue method" << d->channelId << queueName << exchangeName
+             << routingKey;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -732,7 +1069,7 @@ QFuture<void> Channel::queueUnbind(const QString &queueName,
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
 
     return messageTracker->promise.future();
 }
@@ -751,15 +1088,14 @@ bool Channel::onQueueUnbindOk(const MethodFrame &frame)
 
 QFuture<int> Channel::queuePurge(const QString &queueName, bool noWait)
 {
-    MethodFrame frame(d->channelId, spec::queue::ID_, spec::queue::Purge);
+    spec::methods::queue::Purge method;
+    method.queue = queueName;
+    method.noWait = noWait;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageIntPtr messageTracker(new MessagePromise<int>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const QVariantList args({reserved1, queueName, noWait});
-    qDebug() << "Set purge queue method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set purge queue method" << d->channelId << queueName;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -770,7 +1106,7 @@ QFuture<int> Channel::queuePurge(const QString &queueName, bool noWait)
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -780,11 +1116,14 @@ bool Channel::onQueuePurgeOk(const MethodFrame &frame)
     qDebug() << "Purge Queue OK received";
     MessageItemPtr messageTracker(d->popFirstMessageItem(spec::queue::ID_, spec::queue::Purge));
     MessageIntPtr trackedPromise(getPromise<int>(messageTracker));
-    const QVariantList args = frame.getArguments();
-    qDebug() << "messageCount" << args;
+    spec::methods::queue::PurgeOk method;
+    if (!detail::decodeMethod(frame, &method)) {
+        qWarning() << "Failed to get arguments";
+    }
+    qDebug() << "messageCount" << method.messageCount;
     if (messageTracker) {
         if (trackedPromise) {
-            trackedPromise->promise.addResult(args.at(0).toInt());
+            trackedPromise->promise.addResult(int(method.messageCount));
         }
         messageTracker->finish();
     }
@@ -793,18 +1132,18 @@ bool Channel::onQueuePurgeOk(const MethodFrame &frame)
 
 QFuture<int> Channel::queueDelete(const QString &queueName, QueueDeleteOptions opts)
 {
-    MethodFrame frame(d->channelId, spec::queue::ID_, spec::queue::Delete);
+    d->topologyCache()->clear();
+    spec::methods::queue::Delete method;
+    method.queue = queueName;
+    method.ifUnused = opts.testFlag(QueueDeleteOption::IfUnused);
+    method.ifEmpty = opts.testFlag(QueueDeleteOption::IfEmpty);
+    method.noWait = opts.testFlag(QueueDeleteOption::NoWait);
+    const bool noWait = method.noWait;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageIntPtr messageTracker(new MessagePromise<int>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const bool ifUnused = opts.testFlag(QueueDeleteOption::IfUnused);
-    const bool ifEmpty = opts.testFlag(QueueDeleteOption::IfEmpty);
-    const bool noWait = opts.testFlag(QueueDeleteOption::NoWait);
-    const QVariantList args({reserved1, queueName, ifUnused, ifEmpty, noWait});
-    qDebug() << "Set delete queue method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set delete queue method" << d->channelId << queueName;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -815,7 +1154,7 @@ QFuture<int> Channel::queueDelete(const QString &queueName, QueueDeleteOptions o
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -825,11 +1164,14 @@ bool Channel::onQueueDeleteOk(const MethodFrame &frame)
     qDebug() << "Delete Queue OK received";
     MessageItemPtr messageTracker(d->popFirstMessageItem(spec::queue::ID_, spec::queue::Delete));
     MessageIntPtr trackedPromise(getPromise<int>(messageTracker));
-    const QVariantList args = frame.getArguments();
-    qDebug() << "messageCount" << args;
+    spec::methods::queue::DeleteOk method;
+    if (!detail::decodeMethod(frame, &method)) {
+        qWarning() << "Failed to get arguments";
+    }
+    qDebug() << "messageCount" << method.messageCount;
     if (messageTracker) {
         if (trackedPromise) {
-            trackedPromise->promise.addResult(args.at(0).toInt());
+            trackedPromise->promise.addResult(int(method.messageCount));
         }
         messageTracker->finish();
     }
@@ -840,15 +1182,15 @@ bool Channel::onQueueDeleteOk(const MethodFrame &frame)
 // Basic Methods
 QFuture<void> Channel::basicQos(uint prefetchSize, ushort prefetchCount, bool global)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Qos);
+    spec::methods::basic::Qos method;
+    method.prefetchSize = prefetchSize;
+    method.prefetchCount = prefetchCount;
+    method.global = global;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    // Long, Short, Bit
-    const QVariantList args({prefetchSize, QVariant::fromValue<quint16>(prefetchCount), global});
-    qDebug() << "Set qos method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set qos method" << d->channelId << prefetchSize << prefetchCount << global;
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -856,7 +1198,7 @@ QFuture<void> Channel::basicQos(uint prefetchSize, ushort prefetchCount, bool gl
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
 
     return messageTracker->promise.future();
 }
@@ -877,22 +1219,19 @@ QFuture<QString> Channel::basicConsume(const QString &queueName,
                                        const QString &consumerTag,
                                        ConsumeOptions flags)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Consume);
+    spec::methods::basic::Consume method;
+    method.queue = queueName;
+    method.consumerTag = consumerTag;
+    method.noLocal = flags.testFlag(ConsumeOption::NoLocal);
+    method.noAck = flags.testFlag(ConsumeOption::NoAck);
+    method.exclusive = flags.testFlag(ConsumeOption::Exclusive);
+    method.noWait = flags.testFlag(ConsumeOption::NoWait);
+    const bool noWait = method.noWait;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageStrPtr messageTracker(new MessagePromise<QString>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    // Short, QueueName, ConsumerTag, NoLocal, NoAck, Bit, NoWait, Table
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const bool noLocal = flags.testFlag(ConsumeOption::NoLocal);
-    const bool noAck = flags.testFlag(ConsumeOption::NoAck);
-    const bool exclusive = flags.testFlag(ConsumeOption::Exclusive);
-    const bool noWait = flags.testFlag(ConsumeOption::NoWait);
-    const QVariantHash consumeArguments;
-    const QVariantList args(
-        {reserved1, queueName, consumerTag, noLocal, noAck, exclusive, noWait, consumeArguments});
-    qDebug() << "Set consume method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set consume method" << d->channelId << queueName << consumerTag;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -903,7 +1242,7 @@ QFuture<QString> Channel::basicConsume(const QString &queueName,
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -913,11 +1252,14 @@ bool Channel::onBasicConsumeOk(const MethodFrame &frame)
     qDebug() << "Basic Consume OK received";
     MessageItemPtr messageTracker(d->popFirstMessageItem(spec::basic::ID_, spec::basic::Consume));
     MessageStrPtr trackedPromise(getPromise<QString>(messageTracker));
-    const QVariantList args = frame.getArguments();
-    qDebug() << "consumerTag" << args;
+    spec::methods::basic::ConsumeOk method;
+    if (!detail::decodeMethod(frame, &method)) {
+        qWarning() << "Failed to get arguments";
+    }
+    qDebug() << "consumerTag" << method.consumerTag;
     if (messageTracker) {
         if (trackedPromise) {
-            trackedPromise->promise.addResult(args.at(0).toString());
+            trackedPromise->promise.addResult(method.consumerTag);
         }
         messageTracker->finish();
     }
@@ -927,15 +1269,14 @@ bool Channel::onBasicConsumeOk(const MethodFrame &frame)
 
 QFuture<QString> Channel::basicCancel(const QString &consumerTag, bool noWait)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Cancel);
+    spec::methods::basic::Cancel method;
+    method.consumerTag = consumerTag;
+    method.noWait = noWait;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageStrPtr messageTracker(new MessagePromise<QString>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    // ShortStr, Bit
-    const QVariantList args({consumerTag, noWait});
-    qDebug() << "Set qos method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set cancel method" << d->channelId << consumerTag;
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -946,7 +1287,7 @@ QFuture<QString> Channel::basicCancel(const QString &consumerTag, bool noWait)
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
     return messageTracker->promise.future();
 }
@@ -956,11 +1297,14 @@ bool Channel::onBasicCancelOk(const MethodFrame &frame)
     qDebug() << "Basic Cancel OK received";
     MessageItemPtr messageTracker(d->popFirstMessageItem(spec::basic::ID_, spec::basic::Cancel));
     MessageStrPtr trackedPromise(getPromise<QString>(messageTracker));
-    const QVariantList args = frame.getArguments();
-    qDebug() << "consumerTag" << args;
+    spec::methods::basic::CancelOk method;
+    if (!detail::decodeMethod(frame, &method)) {
+        qWarning() << "Failed to get arguments";
+    }
+    qDebug() << "consumerTag" << method.consumerTag;
     if (messageTracker) {
         if (trackedPromise) {
-            trackedPromise->promise.addResult(args.at(0).toString());
+            trackedPromise->promise.addResult(method.consumerTag);
         }
         messageTracker->finish();
     }
@@ -985,61 +1329,92 @@ bool Channel::basicPublish(const QString &message,
 
 bool Channel::basicPublish(const qmq::Message &message, PublishOptions opts)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Publish);
-
-    // Short, ExchangeName, ShortStr, Bit, Bit
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const QString exchangeName = message.exchangeName();
-    const QString routingKey = message.routingKey();
-    const bool mandatory = opts.testFlag(PublishOption::Mandatory);
-    const bool immediate = opts.testFlag(PublishOption::Immediate);
-    const QVariantList args({reserved1, exchangeName, routingKey, mandatory, immediate});
-    qDebug() << "Set publish method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
-
-    if (!isOk) {
+    qDebug() << "Publish" << d->channelId << message.exchangeName() << message.routingKey();
+    Client::Private *client = Client::Private::get(d->client);
+    if (!client->canPublish()) {
         return false;
     }
-
-    // d->inFlightMessages.push_back(messageTracker);
-    const QByteArray &payload = message.payload();
-    HeaderFrame header(d->channelId, frame.classId(), payload.size(), message.properties());
-    isOk = d->client->sendFrame(header);
-    if (!isOk) {
+    d->holdIfBlocked();
+    if (!d->writePublish(d->frameWriter(), message, opts) || !d->commitFrames()) {
         return false;
     }
+    d->publishesSent(1);
+    return true;
+}
 
-    qint64 writtenBytes = 0;
-    const qint64 maxFrameSize = d->client->maxFrameSizeBytes();
-    const qint64 maxPayloadsize = maxFrameSize - 8;
-    while (writtenBytes < payload.size()) {
-        const qint64 len = std::min(maxPayloadsize, payload.size() - writtenBytes);
-        const QByteArray part = payload.mid(writtenBytes, len);
-        BodyFrame body(d->channelId, part);
-        isOk = d->client->sendFrame(body);
-        if (!isOk) {
+bool Channel::basicPublishBatch(const QList<Message> &messages, PublishOptions opts)
+{
+    qDebug() << "Publish batch" << d->channelId << messages.size();
+    Client::Private *client = Client::Private::get(d->client);
+    if (!client->canPublish()) {
+        return false;
+    }
+    d->holdIfBlocked();
+    detail::FrameWriter *writer = d->frameWriter();
+    const qsizetype mark = writer->size();
+    for (const Message &message : messages) {
+        if (!d->writePublish(writer, message, opts)) {
+            writer->rollback(mark);
             return false;
         }
-        writtenBytes += len;
     }
+    if (!d->commitFrames()) {
+        return false;
+    }
+    d->publishesSent(messages.size());
+    return true;
+}
+
+PublishTemplate Channel::publishTemplate(const QString &exchangeName,
+                                         const QString &routingKey,
+                                         const BasicProperties &properties,
+                                         PublishOptions opts)
+{
+    spec::methods::basic::Publish method;
+    method.exchange = exchangeName;
+    method.routingKey = routingKey;
+    method.mandatory = opts.testFlag(PublishOption::Mandatory);
+    method.immediate = opts.testFlag(PublishOption::Immediate);
+
+    detail::FrameWriter writer;
+    if (!writer.writeMethod(d->channelId, method)) {
+        return PublishTemplate();
+    }
+    return PublishTemplate(d->channelId, writer.buffer(), exchangeName, routingKey, properties);
+}
+
+bool Channel::basicPublish(const PublishTemplate &publishTemplate,
+                           QByteArrayView payload,
+                           const QString &messageId,
+                           const QDateTime &timestamp)
+{
+    if (!publishTemplate.isValid() || publishTemplate.channelId() != d->channelId) {
+        qWarning() << "Publish template does not belong to channel" << d->channelId;
+        return false;
+    }
+    Client::Private *client = Client::Private::get(d->client);
+    if (!client->canPublish()) {
+        return false;
+    }
+    d->holdIfBlocked();
+    detail::FrameWriter *writer = d->frameWriter();
+    writer->setMaxFrameSize(d->client->maxFrameSizeBytes());
+    if (!publishTemplate.write(writer, payload, messageId, timestamp) || !d->commitFrames()) {
+        return false;
+    }
+    d->publishesSent(1);
     return true;
 }
 
 bool Channel::onBasicReturn(const MethodFrame &frame)
 {
-    bool isOk = false;
-    // {code, replyText, exchangeName, routingKey}
-    const QVariantList args = frame.getArguments(&isOk);
-    qDebug() << "Return received" << args;
+    spec::methods::basic::Return method;
+    const bool isOk = detail::decodeMethod(frame, &method);
     if (!isOk) {
         qWarning() << "Failed to get arguments";
     }
-
-    const quint16 code = args.at(0).value<quint16>();
-    const QString replyText = args.at(1).toString();
-    const QString exchangeName = args.at(2).toString();
-    const QString routingKey = args.at(3).toString();
+    qDebug() << "Return received" << method.replyCode << method.replyText << method.exchange
+             << method.routingKey;
 
     return isOk;
 }
@@ -1047,40 +1422,32 @@ bool Channel::onBasicReturn(const MethodFrame &frame)
 bool Channel::onBasicDeliver(const MethodFrame &frame)
 {
     qDebug() << "Deliver received";
-    bool isOk = false;
-    // {ConsumerTag, DeliveryTag, Redelivered, ExchangeName, ShortStr};
-    const QVariantList args = frame.getArguments(&isOk);
-    if (!isOk) {
+    spec::methods::basic::Deliver method;
+    if (!detail::decodeMethod(frame, &method)) {
         qWarning() << "Failed to get arguments";
     }
-    const QString consumerTag = args.at(0).toString();
-    const quint64 deliveryTag = args.at(1).toULongLong();
-    const bool redelivered = args.at(2).toBool();
-    const QString exchangeName = args.at(3).toString();
-    const QString routingKey = args.at(4).toString();
 
     d->deliveringMessage.reset(new IncomingMessage);
-    d->deliveringMessage->m_consumerTag = consumerTag;
-    d->deliveringMessage->m_deliveryTag = deliveryTag;
-    d->deliveringMessage->m_exchangeName = exchangeName;
-    d->deliveringMessage->m_redelivered = redelivered;
-    d->deliveringMessage->m_routingKey = routingKey;
+    d->deliveringMessage->m_consumerTag = method.consumerTag;
+    d->deliveringMessage->m_deliveryTag = method.deliveryTag;
+    d->deliveringMessage->m_exchangeName = method.exchange;
+    d->deliveringMessage->m_redelivered = method.redelivered;
+    d->deliveringMessage->m_routingKey = method.routingKey;
 
     return true;
 }
 
 QFuture<QVariantList> Channel::basicGet(const QString &queueName, bool noAck)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Get);
+    spec::methods::basic::Get method;
+    method.queue = queueName;
+    method.noAck = noAck;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageVlistPtr messageTracker(
         new MessagePromise<QVariantList>(frame.classId(), frame.methodId()));
     messageTracker->start();
-    // Short, ShortStr, Bit
-    const QVariant reserved1 = QVariant::fromValue<quint16>(0);
-    const QVariantList args({reserved1, queueName, noAck});
-    qDebug() << "Set get method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set get method" << d->channelId << queueName << noAck;
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -1088,7 +1455,7 @@ QFuture<QVariantList> Channel::basicGet(const QString &queueName, bool noAck)
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
 
     return messageTracker->promise.future();
 }
@@ -1096,26 +1463,19 @@ QFuture<QVariantList> Channel::basicGet(const QString &queueName, bool noAck)
 bool Channel::onBasicGetOk(const MethodFrame &frame)
 {
     qDebug() << "Basic Get OK received";
-    // {DeliveryTag, Redelivered, ExchangeName, ShortStr, Long};
-    bool isOk = false;
-    const QVariantList args = frame.getArguments(&isOk);
-    if (!isOk) {
+    spec::methods::basic::GetOk method;
+    if (!detail::decodeMethod(frame, &method)) {
         qWarning() << "Failed to get arguments";
     }
-    const quint64 deliveryTag = args.at(0).toULongLong();
-    const bool redelivered = args.at(1).toBool();
-    const QString exchangeName = args.at(2).toString();
-    const QString routingKey = args.at(3).toString();
-    const quint32 messageCount = args.at(4).toUInt();
 
     d->deliveringMessage.reset(new IncomingMessage);
     d->deliveringMessage->m_consumerTag = QString();
-    d->deliveringMessage->m_deliveryTag = deliveryTag;
-    d->deliveringMessage->m_exchangeName = exchangeName;
-    d->deliveringMessage->m_redelivered = redelivered;
-    d->deliveringMessage->m_routingKey = routingKey;
+    d->deliveringMessage->m_deliveryTag = method.deliveryTag;
+    d->deliveringMessage->m_exchangeName = method.exchange;
+    d->deliveringMessage->m_redelivered = method.redelivered;
+    d->deliveringMessage->m_routingKey = method.routingKey;
     d->deliveringMessage->m_isGet = true;
-    d->deliveringMessage->m_messageCount = messageCount;
+    d->deliveringMessage->m_messageCount = method.messageCount;
 
     return true;
 }
@@ -1134,12 +1494,12 @@ bool Channel::onBasicGetEmpty(const MethodFrame &frame)
 
 bool Channel::basicAck(quint64 deliveryTag, bool muliple)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Ack);
-
-    const QVariantList args({QVariant::fromValue<quint64>(deliveryTag), muliple});
-    qDebug() << "Set ack method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    spec::methods::basic::Ack method;
+    method.deliveryTag = deliveryTag;
+    method.multiple = muliple;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
+    qDebug() << "Set ack method" << d->channelId << deliveryTag << muliple;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         qWarning() << "Failed to send frame";
@@ -1150,12 +1510,13 @@ bool Channel::basicAck(quint64 deliveryTag, bool muliple)
 
 bool Channel::basicNack(quint64 deliveryTag, bool muliple, bool requeue)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Nack);
-
-    const QVariantList args({QVariant::fromValue<quint64>(deliveryTag), muliple, requeue});
-    qDebug() << "Set nack method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    bool isOk = d->client->sendFrame(frame);
+    spec::methods::basic::Nack method;
+    method.deliveryTag = deliveryTag;
+    method.multiple = muliple;
+    method.requeue = requeue;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
+    qDebug() << "Set nack method" << d->channelId << deliveryTag << muliple << requeue;
+    bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         qWarning() << "Failed to send frame";
@@ -1166,12 +1527,12 @@ bool Channel::basicNack(quint64 deliveryTag, bool muliple, bool requeue)
 
 bool Channel::basicReject(quint64 deliveryTag, bool requeue)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Reject);
-
-    const QVariantList args({QVariant::fromValue<quint64>(deliveryTag), requeue});
-    qDebug() << "Set reject method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+    spec::methods::basic::Reject method;
+    method.deliveryTag = deliveryTag;
+    method.requeue = requeue;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
+    qDebug() << "Set reject method" << d->channelId << deliveryTag << requeue;
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         qWarning() << "Failed to send frame";
@@ -1180,14 +1541,90 @@ bool Channel::basicReject(quint64 deliveryTag, bool requeue)
     return isOk;
 }
 
-bool Channel::basicRecoverAsync(bool requeue)
+AckBatcher *Channel::ackBatcher()
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::RecoverAsync);
+    if (!d->ackBatcher) {
+        d->ackBatcher = new AckBatcher(this);
+    }
+    return d->ackBatcher;
+}
 
-    const QVariantList args = {requeue};
-    qDebug() << "Set recoverAsync method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+QFuture<TopologyResult> Channel::declareTopology(const Topology &topology)
+{
+    struct State
+    {
+        QPromise<TopologyResult> promise;
+        TopologyResult result;
+        qsizetype remaining = 0;
+    };
+    const QSharedPointer<State> state = QSharedPointer<State>::create();
+    state->promise.start();
+    const QFuture<TopologyResult> future = state->promise.future();
+
+    const QList<Topology::Item> &items = topology.items();
+    state->remaining = items.size();
+    state->result.m_results.resize(items.size());
+    for (qsizetype i = 0; i < items.size(); ++i) {
+        state->result.m_results[i].item = items.at(i);
+    }
+    if (items.isEmpty()) {
+        state->promise.addResult(state->result);
+        state->promise.finish();
+        return future;
+    }
+
+    // Every declare goes out in one write; the replies come back in the same order.
+    const Client::Private::WriteBatch batch(Client::Private::get(d->client));
+    for (qsizetype i = 0; i < items.size(); ++i) {
+        const Topology::Item &item = items.at(i);
+        auto settle = [state, i](int code, const QString &text) {
+            TopologyResult::ItemResult &result = state->result.m_results[i];
+            result.errorCode = code;
+            result.errorText = text;
+            if (--state->remaining == 0) {
+                state->promise.addResult(state->result);
+                state->promise.finish();
+            }
+        };
+        switch (item.kind) {
+        case Topology::Item::Kind::Exchange:
+            whenSettled(this->exchangeDeclare(item.name,
+                                              item.exchangeType,
+                                              item.exchangeOptions,
+                                              item.arguments),
+                        settle);
+            break;
+        case Topology::Item::Kind::Queue:
+            whenSettled(this->queueDeclare(item.name, item.queueOptions, item.arguments), settle);
+            break;
+        case Topology::Item::Kind::QueueBinding:
+            whenSettled(this->queueBind(item.name,
+                                        item.source,
+                                        item.routingKey,
+                                        false,
+                                        item.arguments),
+                        settle);
+            break;
+        case Topology::Item::Kind::ExchangeBinding:
+            whenSettled(this->exchangeBind(item.name,
+                                           item.source,
+                                           item.routingKey,
+                                           false,
+                                           item.arguments),
+                        settle);
+            break;
+        }
+    }
+    return future;
+}
+
+bool Channel::basicRecoverAsync(bool requeue)
+{
+    spec::methods::basic::RecoverAsync method;
+    method.requeue = requeue;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
+    qDebug() << "Set recoverAsync method" << d->channelId << requeue;
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         qWarning() << "Failed to send frame";
@@ -1198,15 +1635,13 @@ bool Channel::basicRecoverAsync(bool requeue)
 
 QFuture<void> Channel::basicRecover(bool requeue)
 {
-    MethodFrame frame(d->channelId, spec::basic::ID_, spec::basic::Recover);
+    spec::methods::basic::Recover method;
+    method.requeue = requeue;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    // ShortStr, Bit
-    const QVariantList args = {requeue};
-    qDebug() << "Set recover method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set recover method" << d->channelId << requeue;
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -1214,7 +1649,7 @@ QFuture<void> Channel::basicRecover(bool requeue)
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
 
     return messageTracker->promise.future();
 }
@@ -1235,26 +1670,26 @@ bool Channel::onBasicRecoverOk(const MethodFrame &frame)
 
 QFuture<void> Channel::confirmSelect(bool noWait)
 {
-    MethodFrame frame(d->channelId, spec::confirm::ID_, spec::confirm::Select);
+    spec::methods::confirm::Select method;
+    method.nowait = noWait;
+    const MethodFrame frame = detail::encodeMethod(d->channelId, method);
     MessageItemVoidPtr messageTracker(new MessagePromise<void>(frame.classId(), frame.methodId()));
     messageTracker->start();
-
-    // ShortStr, Bit
-    const QVariantList args = {noWait};
-    qDebug() << "Set confirm select method" << d->channelId << "frame args" << args;
-    frame.setArguments(args);
-    const bool isOk = d->client->sendFrame(frame);
+    qDebug() << "Set confirm select method" << d->channelId << noWait;
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
         messageTracker->finish();
         return messageTracker->promise.future();
     }
+    // The broker numbers publishes from the first one after confirm.select.
+    d->confirms.enable();
 
     if (noWait) {
         messageTracker->finish();
     } else {
-        d->inFlightMessages.push_back(messageTracker);
+        d->trackRpc(messageTracker);
     }
 
     return messageTracker->promise.future();
@@ -1271,6 +1706,71 @@ bool Channel::onConfirmSelectOk(const MethodFrame &frame)
     }
     return true;
 }
+
+bool Channel::isConfirmMode() const
+{
+    return d->confirms.isEnabled();
+}
+
+quint64 Channel::nextPublishSeqNo() const
+{
+    return d->confirms.nextSeqNo();
+}
+
+QFuture<void> Channel::basicPublishConfirmed(const qmq::Message &message, PublishOptions opts)
+{
+    if (!d->confirms.isEnabled()) {
+        return failedFuture(1, "Channel is not in confirm mode");
+    }
+    const quint64 seqNo = d->confirms.nextSeqNo();
+    if (!basicPublish(message, opts)) {
+        return failedFuture(1, "Failed to publish message");
+    }
+    return d->confirms.watch(seqNo, 1);
+}
+
+QFuture<void> Channel::basicPublishBatchConfirmed(const QList<Message> &messages,
+                                                  PublishOptions opts)
+{
+    if (!d->confirms.isEnabled()) {
+        return failedFuture(1, "Channel is not in confirm mode");
+    }
+    const quint64 firstSeqNo = d->confirms.nextSeqNo();
+    if (!basicPublishBatch(messages, opts)) {
+        return failedFuture(1, "Failed to publish batch");
+    }
+    return d->confirms.watch(firstSeqNo, messages.size());
+}
+
+QFuture<void> Channel::waitForConfirms()
+{
+    if (!d->confirms.isEnabled()) {
+        return failedFuture(1, "Channel is not in confirm mode");
+    }
+    return d->confirms.waitForAll();
+}
+
+bool Channel::onBasicAck(const MethodFrame &frame)
+{
+    spec::methods::basic::Ack method;
+    if (!detail::decodeMethod(frame, &method)) {
+        return false;
+    }
+    d->confirms.settle(method.deliveryTag, method.multiple, true);
+    return true;
+}
+
+bool Channel::onBasicNack(const MethodFrame &frame)
+{
+    spec::methods::basic::Nack method;
+    if (!detail::decodeMethod(frame, &method)) {
+        return false;
+    }
+    qDebug() << "Publish nacked" << method.deliveryTag << method.multiple;
+    d->confirms.settle(method.deliveryTag, method.multiple, false);
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // TX
 QFuture<void> Channel::txSelect()
@@ -1281,7 +1781,7 @@ QFuture<void> Channel::txSelect()
 
     // No args.
     qDebug() << "Set Tx Select method" << d->channelId;
-    const bool isOk = d->client->sendFrame(frame);
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -1289,7 +1789,7 @@ QFuture<void> Channel::txSelect()
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
 
     return messageTracker->promise.future();
 }
@@ -1313,7 +1813,7 @@ QFuture<void> Channel::txCommit()
     messageTracker->start();
     // No args.
     qDebug() << "Set Tx Select method" << d->channelId;
-    const bool isOk = d->client->sendFrame(frame);
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -1321,7 +1821,7 @@ QFuture<void> Channel::txCommit()
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
 
     return messageTracker->promise.future();
 }
@@ -1345,7 +1845,7 @@ QFuture<void> Channel::txRollback()
     messageTracker->start();
     // No args.
     qDebug() << "Set Tx Rollback method" << d->channelId;
-    const bool isOk = d->client->sendFrame(frame);
+    const bool isOk = d->sendFrame(frame);
 
     if (!isOk) {
         messageTracker->setException(qmq::Exception(1, "Failed to send frame"));
@@ -1353,7 +1853,7 @@ QFuture<void> Channel::txRollback()
         return messageTracker->promise.future();
     }
 
-    d->inFlightMessages.push_back(messageTracker);
+    d->trackRpc(messageTracker);
 
     return messageTracker->promise.future();
 }
@@ -1373,20 +1873,24 @@ bool Channel::onTxRollbackOk(const MethodFrame &frame)
 // ----------------------------------------------------------------------------
 void Channel::incomingMessageComplete()
 {
-    qDebug() << "Message complete with delivery tag" << d->deliveringMessage->m_deliveryTag
-             << "and size" << d->deliveringMessage->m_payload.size();
+    // Released on return, so that the receive buffer the body may view is not kept alive.
+    const QScopedPointer<IncomingMessage> delivered(d->deliveringMessage.take());
+    const IncomingMessage &incoming = *delivered;
+    qDebug() << "Message complete with delivery tag" << incoming.m_deliveryTag << "and size"
+             << incoming.m_body.size();
+    const QByteArrayView head
+        = incoming.m_body.view().first(qMin<qsizetype>(incoming.m_body.size(), 64));
     qDebug() << "payload"
-             << (QString::fromUtf8(d->deliveringMessage->m_payload.left(64))
-                 + (d->deliveringMessage->m_payload.size() > 64 ? "...[truncated]" : ""));
+             << (QString::fromUtf8(head) + (incoming.m_body.size() > 64 ? "...[truncated]" : ""));
 
-    qmq::Message msg(d->deliveringMessage->m_payload,
-                     d->deliveringMessage->m_exchangeName,
-                     d->deliveringMessage->m_routingKey,
-                     d->deliveringMessage->m_properties);
-    msg.setDeliveryTag(d->deliveringMessage->m_deliveryTag);
-    msg.setRedelivered(d->deliveringMessage->m_redelivered);
+    const MessageView view(incoming.m_body,
+                           incoming.m_exchangeName,
+                           incoming.m_routingKey,
+                           incoming.m_properties,
+                           incoming.m_deliveryTag,
+                           incoming.m_redelivered);
 
-    if (d->deliveringMessage->m_isGet) {
+    if (incoming.m_isGet) {
         MessageItemPtr messageTracker(d->popFirstMessageItem(spec::basic::ID_, spec::basic::Get));
         if (!messageTracker) {
             qWarning() << "Unexpected message";
@@ -1394,17 +1898,18 @@ void Channel::incomingMessageComplete()
         }
         MessageVlistPtr trackedPromise(getPromise<QVariantList>(messageTracker));
 
-        const QVariantList promiseArgs = {QVariant::fromValue<qmq::Message>(msg),
-                                          d->deliveringMessage->m_messageCount};
+        const QVariantList promiseArgs = {QVariant::fromValue<qmq::Message>(view.toMessage()),
+                                          incoming.m_messageCount};
         trackedPromise->promise.addResult(promiseArgs);
         trackedPromise->finish();
     } else {
-        const QString consumerTag = d->deliveringMessage->m_consumerTag;
-        auto consumerIt = d->consumers.find(consumerTag);
-        if (consumerIt == d->consumers.end()) {
+        auto consumerIt = d->consumers.find(incoming.m_consumerTag);
+        if (consumerIt == d->consumers.end() || !consumerIt.value()) {
             qWarning() << "No consumer found for message";
+        } else if (consumerIt.value()->hasHandler()) {
+            consumerIt.value()->handler()(view);
         } else {
-            consumerIt.value()->pushMessage(msg);
+            consumerIt.value()->pushMessage(view.toMessage());
         }
     }
 }
@@ -1414,11 +1919,133 @@ void Channel::emptyMessageTracking(int code, const QString &message)
     if (!d->inFlightMessages.isEmpty()) {
         qWarning() << "Channel closed with" << d->inFlightMessages.size() << "messages pending";
     }
-    while (!d->inFlightMessages.isEmpty()) {
-        MessageItemPtr it = d->inFlightMessages.takeFirst();
-        it->setException(qmq::Exception(code, message));
-        it->finish();
+    if (d->client) {
+        d->topologyCache()->clear();
+        d->uncountHeldFrames();
+    }
+    d->heldFrames.clear();
+    d->releaseScheduled = false;
+    d->blockedHold = false;
+    d->inFlightMessages.failAll(qmq::Exception(code, message));
+    d->confirms.reset(code, message);
+    if (d->ackBatcher) {
+        d->ackBatcher->reset();
+    }
+}
+
+class PublishBatch::Private
+{
+public:
+    QPointer<Channel> channel;
+    detail::FrameWriter writer;
+    int count = 0;
+};
+
+PublishBatch::PublishBatch(Channel *channel)
+    : d(new Private)
+{
+    d->channel = channel;
+}
+
+PublishBatch::~PublishBatch() = default;
+
+bool PublishBatch::add(const Message &message, PublishOptions opts)
+{
+    if (!d->channel) {
+        qWarning() << "Cannot add to publish batch: no channel";
+        return false;
+    }
+    if (!d->channel->d->writePublish(&d->writer, message, opts)) {
+        return false;
+    }
+    ++d->count;
+    return true;
+}
+
+bool PublishBatch::add(const PublishTemplate &publishTemplate,
+                       QByteArrayView payload,
+                       const QString &messageId,
+                       const QDateTime &timestamp)
+{
+    if (!d->channel || !publishTemplate.isValid()
+        || publishTemplate.channelId() != d->channel->d->channelId) {
+        qWarning() << "Publish template does not belong to the batch channel";
+        return false;
+    }
+    d->writer.setMaxFrameSize(d->channel->d->client->maxFrameSizeBytes());
+    if (!publishTemplate.write(&d->writer, payload, messageId, timestamp)) {
+        return false;
+    }
+    ++d->count;
+    return true;
+}
+
+int PublishBatch::size() const
+{
+    return d->count;
+}
+
+qsizetype PublishBatch::encodedSize() const
+{
+    return d->writer.size();
+}
+
+void PublishBatch::clear()
+{
+    d->writer.clear();
+    d->count = 0;
+}
+
+bool PublishBatch::publish()
+{
+    if (!d->channel) {
+        qWarning() << "Cannot publish batch: no channel";
+        clear();
+        return false;
+    }
+    qDebug() << "Publish batch" << d->channel->channelId() << d->count;
+    Client::Private *client = Client::Private::get(d->channel->d->client);
+    if (!client->canPublish()) {
+        // The batch is kept, so that it can be published once the client is writable.
+        return false;
+    }
+    d->channel->d->holdIfBlocked();
+    const int count = d->count;
+    d->count = 0;
+    bool isOk = false;
+    if (d->channel->d->isHoldingFrames()) {
+        d->channel->d->heldFrames.writeEncoded(d->writer.buffer());
+        d->channel->d->countHeldFrames();
+        d->writer.clear();
+        isOk = true;
+    } else if (client->writeMode == Client::WriteMode::Immediate && client->writer.isEmpty()
+        && !client->isHoldingFrames() && client->socket != nullptr) {
+        // Nothing else is queued, so the batch buffer goes to the socket as it is.
+        isOk = d->writer.flush(client->socket);
+        client->updateWritable();
+    } else {
+        client->writer.writeEncoded(d->writer.buffer());
+        d->writer.clear();
+        isOk = client->commitFrames();
+    }
+    if (isOk) {
+        d->channel->d->publishesSent(count);
+    }
+    return isOk;
+}
+
+QFuture<void> PublishBatch::publishConfirmed()
+{
+    if (!d->channel || !d->channel->d->confirms.isEnabled()) {
+        return failedFuture(1, "Channel is not in confirm mode");
+    }
+    detail::ConfirmTracker &confirms = d->channel->d->confirms;
+    const quint64 firstSeqNo = confirms.nextSeqNo();
+    const int count = d->count;
+    if (!publish()) {
+        return failedFuture(1, "Failed to publish batch");
     }
+    return confirms.watch(firstSeqNo, count);
 }
 
 } // namespace qmq
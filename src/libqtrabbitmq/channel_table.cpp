@@ -0,0 +1,73 @@
+#include "channel_table.h"
+
+#include <qtrabbitmq/channel.h>
+
+#include <QtAlgorithms>
+
+namespace qmq::detail {
+
+quint16 ChannelTable::allocate(quint16 maxChannelId)
+{
+    if (maxChannelId == 0) {
+        return 0;
+    }
+    ensureSize(maxChannelId);
+    if (m_nextId == 0 || m_nextId > maxChannelId) {
+        m_nextId = 1;
+    }
+    // Two passes: from m_nextId to the end, then wrapping around from 1.
+    const quint32 limit = quint32(maxChannelId) + 1;
+    quint32 id = m_nextId;
+    for (int pass = 0; pass < 2; ++pass) {
+        while (id < limit) {
+            const quint64 word = m_usedBits[id / 64] | ((quint64(1) << (id % 64)) - 1);
+            if (word == ~quint64(0)) {
+                id = (id / 64 + 1) * 64;
+                continue;
+            }
+            id = (id / 64) * 64 + qCountTrailingZeroBits(~word);
+            if (id >= limit) {
+                break;
+            }
+            m_nextId = quint16(id + 1);
+            return quint16(id);
+        }
+        id = 1;
+    }
+    return 0;
+}
+
+void ChannelTable::insert(quint16 channelId, const QSharedPointer<Channel> &channel)
+{
+    ensureSize(channelId);
+    if (!isUsed(channelId)) {
+        ++m_count;
+    }
+    m_usedBits[channelId / 64] |= quint64(1) << (channelId % 64);
+    m_channels[channelId] = channel;
+}
+
+QList<QSharedPointer<Channel>> ChannelTable::channels() const
+{
+    QList<QSharedPointer<Channel>> result;
+    result.reserve(m_count);
+    for (const QSharedPointer<Channel> &channel : m_channels) {
+        if (channel) {
+            result.append(channel);
+        }
+    }
+    return result;
+}
+
+void ChannelTable::ensureSize(quint16 maxChannelId)
+{
+    const size_t size = size_t(maxChannelId) + 1;
+    if (m_channels.size() < size) {
+        m_channels.resize(size);
+        m_usedBits.resize((size + 63) / 64, 0);
+        // The connection's channel.
+        m_usedBits[0] |= 1;
+    }
+}
+
+} // namespace qmq::detail
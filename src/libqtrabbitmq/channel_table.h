@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QList>
+#include <QSharedPointer>
+#include <qglobal.h>
+
+#include <vector>
+
+namespace qmq {
+class Channel;
+
+namespace detail {
+
+//! The channels of a connection, indexed directly by channel id.
+//!
+//! find() is a bounds check and an array read, with no hashing and no reference counting, so
+//! routing a frame costs the same for 1 or 2000 channels. Used ids are tracked in a bitmap;
+//! allocate() takes the first free id from where the previous search stopped, so ids are handed
+//! out round-robin like before and a free one is found a 64-id word at a time.
+class ChannelTable
+{
+public:
+    //! Channel \a channelId, or null. The table keeps the channel alive.
+    Channel *find(quint16 channelId) const
+    {
+        return channelId < m_channels.size() ? m_channels[channelId].data() : nullptr;
+    }
+    QSharedPointer<Channel> value(quint16 channelId) const
+    {
+        return channelId < m_channels.size() ? m_channels[channelId] : QSharedPointer<Channel>();
+    }
+    bool contains(quint16 channelId) const { return find(channelId) != nullptr; }
+    qsizetype size() const { return m_count; }
+
+    //! A free id in 1..maxChannelId, or 0 if all of them are in use.
+    quint16 allocate(quint16 maxChannelId);
+    void insert(quint16 channelId, const QSharedPointer<Channel> &channel);
+
+    //! The channels in id order.
+    QList<QSharedPointer<Channel>> channels() const;
+
+private:
+    void ensureSize(quint16 maxChannelId);
+    bool isUsed(quint16 channelId) const
+    {
+        return (m_usedBits[channelId / 64] >> (channelId % 64)) & 1;
+    }
+
+    std::vector<QSharedPointer<Channel>> m_channels;
+    // Bit (id % 64) of word (id / 64) is set when the id is taken. Id 0 is the connection's.
+    std::vector<quint64> m_usedBits;
+    quint16 m_nextId = 1;
+    qsizetype m_count = 0;
+};
+
+} // namespace detail
+} // namespace qmq
@@ -2,15 +2,18 @@
 #include <qtrabbitmq/channel.h>
 #include <qtrabbitmq/client.h>
 
+#include "client_p.h"
 #include "connection_handler.h"
 #include "spec_constants.h"
 
 #include <QByteArray>
 #include <QSslSocket>
 #include <QString>
+#include <QThread>
 #include <QTimer>
 #include <QUrl>
 
+#include <climits>
 #include <memory>
 
 namespace {
@@ -27,32 +30,275 @@ QByteArray protocolHeader()
 
 namespace qmq {
 
-class Client::Private
-{
-public:
-    QSslSocket *socket = nullptr;
-    QUrl url;
-    QString vhost;
-    QString userName;
-    QString password;
-    QSharedPointer<detail::ConnectionHandler> connection;
-    quint32 maxFrameSizeBytes = 1024 * 1024;
-    QHash<quint16, QSharedPointer<qmq::Channel>> channels;
-    quint16 nextChannelId = 1;
-    quint16 maxChannelId = 2047;
-    quint16 heartbeatSeconds = 60;
-    ConnectionState state = ConnectionState::Closed;
-};
+bool Client::Private::commitFrames()
+{
+    if (!socket) {
+        qWarning() << "Cannot write frames: not connected";
+        writer.clear();
+        return false;
+    }
+    if (isHoldingFrames()) {
+        // Written by onSocketBytesWritten() once the socket has drained.
+        return true;
+    }
+    if (writeBatchDepth > 0 && writer.size() < flushThresholdBytes) {
+        // Written by endWriteBatch().
+        return true;
+    }
+    if (writeMode == WriteMode::Immediate || writer.size() >= flushThresholdBytes) {
+        return flushWriter();
+    }
+    if (!flushScheduled) {
+        flushScheduled = true;
+        QMetaObject::invokeMethod(
+            q,
+            [this]() {
+                flushScheduled = false;
+                if (!isHoldingFrames()) {
+                    flushWriter();
+                }
+            },
+            Qt::QueuedConnection);
+    }
+    return true;
+}
+
+bool Client::Private::flushWriter()
+{
+    if (!socket) {
+        qWarning() << "Cannot write frames: not connected";
+        writer.clear();
+        return false;
+    }
+    const bool isOk = writer.flush(socket);
+    updateWritable();
+    return isOk;
+}
+
+bool Client::Private::canPublish() const
+{
+    if (isPublishGated()) {
+        if (gatedBytes >= publishQueueLimitBytes) {
+            qWarning() << "Cannot publish: connection blocked and publish queue full" << gatedBytes;
+            return false;
+        }
+        return true;
+    }
+    if (writable) {
+        return true;
+    }
+    switch (backpressurePolicy) {
+    case BackpressurePolicy::Ignore:
+        return true;
+    case BackpressurePolicy::FailFast:
+        qWarning() << "Cannot publish: outbound buffer above high watermark" << bytesToWrite();
+        return false;
+    case BackpressurePolicy::Queue:
+        if (writer.size() >= publishQueueLimitBytes) {
+            qWarning() << "Cannot publish: publish queue full" << writer.size();
+            return false;
+        }
+        return true;
+    }
+    return true;
+}
+
+qint64 Client::Private::bytesToWrite() const
+{
+    return writer.size() + (socket ? socket->bytesToWrite() : 0);
+}
+
+void Client::Private::updateWritable()
+{
+    const qint64 pending = bytesToWrite();
+    // Frames held back by the Queue policy do not count towards the low watermark: they are
+    // what gets written once it is reached.
+    const qint64 socketPending = socket ? socket->bytesToWrite() : 0;
+    bool nowWritable = writable;
+    if (highWatermarkBytes <= 0) {
+        nowWritable = true;
+    } else if (writable && pending >= highWatermarkBytes) {
+        nowWritable = false;
+    } else if (!writable && socketPending <= lowWatermarkBytes) {
+        nowWritable = true;
+    }
+    if (nowWritable != writable) {
+        qDebug() << "Client writable" << nowWritable << "with" << pending << "bytes to write";
+        writable = nowWritable;
+        if (writable && socket && !writer.isEmpty()
+            && backpressurePolicy == BackpressurePolicy::Queue) {
+            // Frames held back while the client was not writable.
+            flushWriter();
+        }
+        emit q->writable(nowWritable);
+    }
+}
+
+bool Client::Private::submit(detail::Submission &&submission)
+{
+    if (!submissions) {
+        qWarning() << "Cannot post without an I/O thread; call Client::startIoThread() first";
+        return false;
+    }
+    if (!submissions->tryPush(std::move(submission))) {
+        return false;
+    }
+    // One queued call covers everything submitted until the I/O thread gets to it.
+    if (!drainPosted.exchange(true)) {
+        QMetaObject::invokeMethod(
+            q, [this]() { drainSubmissions(); }, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void Client::Private::drainSubmissions()
+{
+    // Pairs with the exchange in submit(), so submissions pushed before it are seen below.
+    drainPosted.exchange(false);
+    const WriteBatch batch(this);
+    detail::Submission submission;
+    while (submissions->tryPop(&submission)) {
+        runSubmission(submission);
+    }
+}
+
+void Client::Private::endWriteBatch()
+{
+    if (socket && !writer.isEmpty() && !isHoldingFrames()
+        && (writeMode == WriteMode::Immediate || !flushScheduled)) {
+        flushWriter();
+    }
+}
+
+void Client::Private::armTimerWheel()
+{
+    const qint64 ms = timers.msUntilNextEvent();
+    if (ms < 0) {
+        timerWheelTimer->stop();
+    } else {
+        timerWheelTimer->start(int(qMin<qint64>(ms, INT_MAX)));
+    }
+}
+
+void Client::Private::startConnectionTimer()
+{
+    timers.cancel(connectionTimer);
+    connectionTimer = 0;
+    if (connectionTimeoutMs <= 0) {
+        return;
+    }
+    connectionTimer = timers.start(connectionTimeoutMs, [this]() {
+        connectionTimer = 0;
+        qWarning() << "Connection handshake timed out";
+        if (socket) {
+            socket->abort();
+        }
+    });
+}
+
+void Client::Private::runSubmission(detail::Submission &submission)
+{
+    if (submission.kind == detail::Submission::Kind::Call) {
+        submission.call(q);
+        return;
+    }
+    const QSharedPointer<Channel> channel = channels.value(submission.channelId);
+    if (!channel) {
+        qWarning() << "Posted to unknown channel" << submission.channelId;
+        return;
+    }
+    switch (submission.kind) {
+    case detail::Submission::Kind::Publish:
+        channel->basicPublish(submission.message, submission.publishOptions);
+        break;
+    case detail::Submission::Kind::Ack:
+        channel->basicAck(submission.deliveryTag, submission.multiple);
+        break;
+    case detail::Submission::Kind::Nack:
+        channel->basicNack(submission.deliveryTag, submission.multiple, submission.requeue);
+        break;
+    case detail::Submission::Kind::Reject:
+        channel->basicReject(submission.deliveryTag, submission.requeue);
+        break;
+    case detail::Submission::Kind::None:
+    case detail::Submission::Kind::Call:
+        break;
+    }
+}
+
+void Client::Private::fillReadBuffer()
+{
+    if (socket->bytesAvailable() <= 0) {
+        return;
+    }
+    if (readOffset >= readBuffer.size()) {
+        readBuffer = socket->readAll();
+    } else {
+        // Carry over the incomplete frame into a new buffer rather than appending, so that
+        // frames still holding views on the old buffer never force it to detach.
+        const qsizetype remaining = readBuffer.size() - readOffset;
+        QByteArray next;
+        next.reserve(remaining + socket->bytesAvailable());
+        next.append(readBuffer.constData() + readOffset, remaining);
+        next.append(socket->readAll());
+        readBuffer = next;
+    }
+    readOffset = 0;
+}
 
 Client::Client(QObject *parent)
     : QObject(parent)
-    , d(new Private)
+    , d(new Private(this))
 {
+    d->timerWheelTimer = new QTimer(this);
+    d->timerWheelTimer->setSingleShot(true);
+    connect(d->timerWheelTimer, &QTimer::timeout, this, [this]() {
+        d->timers.advance();
+        d->armTimerWheel();
+    });
+    d->timers.setWakeupHandler([this](qint64 delayMs) {
+        if (!d->timerWheelTimer->isActive() || d->timerWheelTimer->remainingTime() > delayMs) {
+            d->timerWheelTimer->start(int(qMin<qint64>(delayMs, INT_MAX)));
+        }
+    });
+
     d->connection.reset(new detail::ConnectionHandler(this));
+    connect(d->connection.data(),
+            &detail::ConnectionHandler::connectionOpened,
+            this,
+            [this]() {
+                d->timers.cancel(d->connectionTimer);
+                d->connectionTimer = 0;
+            });
     connect(d->connection.data(),
             &detail::ConnectionHandler::connectionOpened,
             this,
             &Client::connected);
+    connect(d->connection.data(),
+            &detail::ConnectionHandler::connectionBlocked,
+            this,
+            [this](const QString &reason) {
+                qWarning() << "Connection blocked by the broker:" << reason;
+                d->blocked = true;
+                emit blocked(reason);
+            });
+    connect(d->connection.data(),
+            &detail::ConnectionHandler::connectionUnblocked,
+            this,
+            [this]() {
+                qDebug() << "Connection unblocked";
+                d->blocked = false;
+                emit unblocked();
+            });
+    connect(d->connection.data(),
+            &detail::ConnectionHandler::connectionClosed,
+            this,
+            [this]() {
+                d->timers.cancel(d->connectionTimer);
+                d->connectionTimer = 0;
+                d->topologyCache.clear();
+                d->blocked = false;
+            });
     connect(d->connection.data(),
             &detail::ConnectionHandler::connectionClosed,
             this,
@@ -61,9 +307,114 @@ Client::Client(QObject *parent)
 
 Client::~Client()
 {
+    if (d->ioThread) {
+        // The socket, the wheel's timer and the handlers live on the I/O thread. They are
+        // stopped there and moved back to this thread, which then deletes them.
+        QThread *const owner = QThread::currentThread();
+        if (owner == d->ioThread.get()) {
+            qWarning() << "A client must not be destroyed on its own I/O thread";
+        } else if (d->ioThread->isRunning()) {
+            QMetaObject::invokeMethod(
+                this,
+                [this, owner]() {
+                    if (d->socket) {
+                        d->socket->abort();
+                    }
+                    d->timerWheelTimer->stop();
+                    d->connection->moveToThread(owner);
+                    for (const QSharedPointer<Channel> &channel : d->channels.channels()) {
+                        channel->moveToThread(owner);
+                    }
+                    this->moveToThread(owner);
+                },
+                Qt::BlockingQueuedConnection);
+        }
+        d->ioThread->quit();
+        d->ioThread->wait();
+    }
     d.reset();
 }
 
+bool Client::startIoThread(int queueCapacity)
+{
+    if (d->ioThread) {
+        return true;
+    }
+    if (this->parent()) {
+        qWarning() << "Cannot move a client with a parent to an I/O thread";
+        return false;
+    }
+    if (this->thread() != QThread::currentThread()) {
+        qWarning() << "startIoThread() must be called from the client's thread";
+        return false;
+    }
+    d->submissions.reset(
+        new detail::MpscQueue<detail::Submission>(size_t(qMax(queueCapacity, 2))));
+    d->ioThread.reset(new QThread);
+    d->ioThread->setObjectName(QStringLiteral("qmq-io"));
+    d->connection->moveToThread(d->ioThread.get());
+    for (const QSharedPointer<Channel> &channel : d->channels.channels()) {
+        channel->moveToThread(d->ioThread.get());
+    }
+    this->moveToThread(d->ioThread.get());
+    d->ioThread->start();
+    return true;
+}
+
+bool Client::hasIoThread() const
+{
+    return !d->ioThread.isNull();
+}
+
+bool Client::postPublish(quint16 channelId, Message message, PublishOptions opts)
+{
+    detail::Submission submission;
+    submission.kind = detail::Submission::Kind::Publish;
+    submission.channelId = channelId;
+    submission.message = std::move(message);
+    submission.publishOptions = opts;
+    return d->submit(std::move(submission));
+}
+
+bool Client::postAck(quint16 channelId, quint64 deliveryTag, bool multiple)
+{
+    detail::Submission submission;
+    submission.kind = detail::Submission::Kind::Ack;
+    submission.channelId = channelId;
+    submission.deliveryTag = deliveryTag;
+    submission.multiple = multiple;
+    return d->submit(std::move(submission));
+}
+
+bool Client::postNack(quint16 channelId, quint64 deliveryTag, bool multiple, bool requeue)
+{
+    detail::Submission submission;
+    submission.kind = detail::Submission::Kind::Nack;
+    submission.channelId = channelId;
+    submission.deliveryTag = deliveryTag;
+    submission.multiple = multiple;
+    submission.requeue = requeue;
+    return d->submit(std::move(submission));
+}
+
+bool Client::postReject(quint16 channelId, quint64 deliveryTag, bool requeue)
+{
+    detail::Submission submission;
+    submission.kind = detail::Submission::Kind::Reject;
+    submission.channelId = channelId;
+    submission.deliveryTag = deliveryTag;
+    submission.requeue = requeue;
+    return d->submit(std::move(submission));
+}
+
+bool Client::post(std::function<void(Client *)> fn)
+{
+    detail::Submission submission;
+    submission.kind = detail::Submission::Kind::Call;
+    submission.call = std::move(fn);
+    return d->submit(std::move(submission));
+}
+
 QString Client::username() const
 {
     return d->userName;
@@ -156,16 +507,25 @@ bool Client::connectToHost(const QUrl &url)
         d->password = qEnvironmentVariable("RABBITMQ_PASS");
     }
 
+    d->topologyCache.clear();
+    d->readBuffer.clear();
+    d->readOffset = 0;
+    d->discardingInput = false;
+    d->writer.clear();
+    d->writable = true;
+    d->blocked = false;
     d->socket = new QSslSocket(this);
     d->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
     d->socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
     connect(d->socket, &QAbstractSocket::connected, this, &Client::onSocketConnected);
     connect(d->socket, &QAbstractSocket::readyRead, this, &Client::onSocketReadyRead);
+    connect(d->socket, &QAbstractSocket::bytesWritten, this, &Client::onSocketBytesWritten);
     connect(d->socket, &QAbstractSocket::errorOccurred, this, &Client::onSocketErrorOccurred);
     connect(d->socket, &QAbstractSocket::stateChanged, this, &Client::onSocketStateChanged);
     connect(d->socket, &QSslSocket::sslErrors, this, &Client::onSocketSslErrors);
 
     d->state = ConnectionState::Opening;
+    d->startConnectionTimer();
     if (useSsl) {
         d->socket->connectToHostEncrypted(url.host(), port);
     } else {
@@ -181,8 +541,20 @@ QString Client::virtualHost() const
 
 bool Client::sendFrame(const Frame &frame)
 {
-    const quint32 maxFrameSize = this->maxFrameSizeBytes();
-    return Frame::writeFrame(d->socket, maxFrameSize, frame);
+    d->writer.setMaxFrameSize(this->maxFrameSizeBytes());
+    if (!d->writer.writeFrame(frame)) {
+        return false;
+    }
+    return d->commitFrames();
+}
+
+bool Client::flush()
+{
+    d->flushScheduled = false;
+    if (d->writer.isEmpty()) {
+        return true;
+    }
+    return d->flushWriter();
 }
 
 void Client::onSocketConnected()
@@ -194,62 +566,265 @@ void Client::onSocketConnected()
 void Client::onSocketReadyRead()
 {
     qDebug() << "Ready read";
+    d->drainScheduled = false;
+    if (d->discardingInput) {
+        d->socket->readAll();
+        return;
+    }
+    d->fillReadBuffer();
+
     const quint32 maxFrameSize = d->connection->maxFrameSizeBytes();
-    ErrorCode errCode = qmq::ErrorCode::NoError;
-    std::unique_ptr<Frame> frame(Frame::readFrame(d->socket, maxFrameSize, &errCode));
-    if (frame) {
-        qDebug() << "Read frame with type=" << (int) frame->type();
-    } else {
-        qDebug() << "No frame" << (int) errCode << d->socket->bytesAvailable();
+    int frameCount = 0;
+    qint64 bytesRead = 0;
+    bool budgetExhausted = false;
+    while (!budgetExhausted) {
+        ErrorCode errCode = qmq::ErrorCode::NoError;
+        const qsizetype frameStart = d->readOffset;
+        std::unique_ptr<Frame> frame(
+            Frame::readFrame(d->readBuffer, &d->readOffset, maxFrameSize, &errCode));
+        if (!frame) {
+            if (errCode != ErrorCode::InsufficientDataAvailable) {
+                // Nothing after a malformed frame can be framed again, which AMQP makes a
+                // connection error. The broker's reply is dropped with the rest of the input.
+                qWarning() << "Failed to decode frame" << (int) errCode << "- closing connection";
+                d->readBuffer.clear();
+                d->readOffset = 0;
+                d->discardingInput = true;
+                this->disconnectFromHost(spec::constants::FrameRrror, "Frame error");
+                return;
+            }
+            // Data that arrived while dispatching does not trigger another readyRead.
+            if (d->socket->bytesAvailable() <= 0) {
+                break;
+            }
+            d->fillReadBuffer();
+            continue;
+        }
+        ++frameCount;
+        bytesRead += d->readOffset - frameStart;
+        this->dispatchFrame(*frame);
+
+        budgetExhausted = (d->maxFramesPerRead > 0 && frameCount >= d->maxFramesPerRead)
+                          || (d->maxBytesPerRead > 0 && bytesRead >= d->maxBytesPerRead);
+    }
+    qDebug() << "Dispatched" << frameCount << "frames";
+
+    // Any traffic counts as a heartbeat; one clock read covers the whole read.
+    if (frameCount > 0) {
+        d->lastReadMs = d->timers.now();
+    }
+
+    if (budgetExhausted && !d->drainScheduled
+        && (d->readOffset < d->readBuffer.size() || d->socket->bytesAvailable() > 0)) {
+        qDebug() << "More data to come";
+        // Allow event loop to do some work (timers, heartbeats) before continuing.
+        d->drainScheduled = true;
+        QTimer::singleShot(std::chrono::milliseconds(0), this, &Client::onSocketReadyRead);
+    }
+}
+
+void Client::onSocketBytesWritten(qint64 bytes)
+{
+    Q_UNUSED(bytes);
+    d->lastWriteMs = d->timers.now();
+    if (d->writable) {
         return;
     }
-    QSharedPointer<AbstractFrameHandler> handler;
-    if (frame->channel() == 0) {
-        handler = d->connection;
+    d->updateWritable();
+}
+
+bool Client::dispatchFrame(const Frame &frame)
+{
+    // Plain pointers: the connection handler and the channel table own the handlers.
+    AbstractFrameHandler *handler = nullptr;
+    if (frame.channel() == 0) {
+        handler = d->connection.data();
     } else {
-        handler = d->channels.value(frame->channel());
+        handler = d->channels.find(frame.channel());
     }
     if (!handler) {
-        qWarning() << "No handler for channel" << frame->channel();
-        return;
+        qWarning() << "No handler for channel" << frame.channel();
+        return false;
     }
 
     bool isHandled = false;
-    switch (frame->type()) {
-    case FrameType::Method: {
-        qDebug() << "Method frame on channel" << frame->channel();
-        const MethodFrame &methodFr = static_cast<const MethodFrame &>(*frame);
-        isHandled = handler->handleMethodFrame(methodFr);
-    } break;
+    switch (frame.type()) {
+    case FrameType::Method:
+        qDebug() << "Method frame on channel" << frame.channel();
+        isHandled = handler->handleMethodFrame(static_cast<const MethodFrame &>(frame));
+        break;
     case FrameType::Header:
-        qDebug() << "Header frame on channel" << frame->channel();
-        isHandled = handler->handleHeaderFrame(static_cast<const HeaderFrame &>(*frame.get()));
+        qDebug() << "Header frame on channel" << frame.channel();
+        isHandled = handler->handleHeaderFrame(static_cast<const HeaderFrame &>(frame));
         break;
     case FrameType::Body:
-        qDebug() << "Body frame on channel" << frame->channel();
-        isHandled = handler->handleBodyFrame(static_cast<const BodyFrame &>(*frame.get()));
+        qDebug() << "Body frame on channel" << frame.channel();
+        isHandled = handler->handleBodyFrame(static_cast<const BodyFrame &>(frame));
         break;
     case FrameType::Heartbeat:
-        qDebug() << "Heartbeat frame on channel" << frame->channel();
-        isHandled = handler->handleHeartbeatFrame(static_cast<const HeartbeatFrame &>(*frame.get()));
+        qDebug() << "Heartbeat frame on channel" << frame.channel();
+        isHandled = handler->handleHeartbeatFrame(static_cast<const HeartbeatFrame &>(frame));
         break;
     default:
-        qWarning() << "Unknown frame type" << (int) frame->type();
+        qWarning() << "Unknown frame type" << (int) frame.type();
         break;
     }
 
-    // Any activity should reset the heartbeat timeout.
-    d->connection->resetTrafficFromServerHeartbeat();
-
-    if (d->socket->bytesAvailable() > 0) {
-        qDebug() << "More data to come";
-        // Allow event loop to do some work if needed.
-        QTimer::singleShot(std::chrono::milliseconds(0), this, &Client::onSocketReadyRead);
-    }
     if (!isHandled) {
-        qWarning() << "Unhandled frame type" << (int) frame->type() << "on channel"
-                   << frame->channel();
+        qWarning() << "Unhandled frame type" << (int) frame.type() << "on channel"
+                   << frame.channel();
     }
+    return isHandled;
+}
+
+Client::WriteMode Client::writeMode() const
+{
+    return d->writeMode;
+}
+
+void Client::setWriteMode(WriteMode mode)
+{
+    d->writeMode = mode;
+    if (mode == WriteMode::Immediate && d->socket != nullptr) {
+        this->flush();
+    }
+}
+
+qint64 Client::flushThresholdBytes() const
+{
+    return d->flushThresholdBytes;
+}
+
+void Client::setFlushThresholdBytes(qint64 n)
+{
+    d->flushThresholdBytes = n;
+}
+
+qint64 Client::bytesToWrite() const
+{
+    return d->bytesToWrite();
+}
+
+bool Client::isWritable() const
+{
+    return d->writable;
+}
+
+qint64 Client::highWatermarkBytes() const
+{
+    return d->highWatermarkBytes;
+}
+
+void Client::setHighWatermarkBytes(qint64 n)
+{
+    d->highWatermarkBytes = n;
+    d->updateWritable();
+}
+
+qint64 Client::lowWatermarkBytes() const
+{
+    return d->lowWatermarkBytes;
+}
+
+void Client::setLowWatermarkBytes(qint64 n)
+{
+    d->lowWatermarkBytes = n;
+    d->updateWritable();
+}
+
+Client::BackpressurePolicy Client::backpressurePolicy() const
+{
+    return d->backpressurePolicy;
+}
+
+void Client::setBackpressurePolicy(BackpressurePolicy policy)
+{
+    d->backpressurePolicy = policy;
+}
+
+qint64 Client::publishQueueLimitBytes() const
+{
+    return d->publishQueueLimitBytes;
+}
+
+void Client::setPublishQueueLimitBytes(qint64 n)
+{
+    d->publishQueueLimitBytes = n;
+}
+
+int Client::rpcTimeoutMs() const
+{
+    return d->rpcTimeoutMs;
+}
+
+void Client::setRpcTimeoutMs(int ms)
+{
+    d->rpcTimeoutMs = ms;
+}
+
+bool Client::isBlocked() const
+{
+    return d->blocked;
+}
+
+bool Client::isPublishGatingEnabled() const
+{
+    return d->publishGating;
+}
+
+void Client::setPublishGatingEnabled(bool enabled)
+{
+    d->publishGating = enabled;
+}
+
+int Client::connectionTimeoutMs() const
+{
+    return d->connectionTimeoutMs;
+}
+
+void Client::setConnectionTimeoutMs(int ms)
+{
+    d->connectionTimeoutMs = ms;
+}
+
+quint64 Client::startTimeout(int ms, std::function<void()> callback)
+{
+    return d->timers.start(ms, std::move(callback));
+}
+
+void Client::cancelTimeout(quint64 id)
+{
+    d->timers.cancel(id);
+}
+
+bool Client::isTopologyCacheEnabled() const
+{
+    return d->topologyCache.isEnabled();
+}
+
+void Client::setTopologyCacheEnabled(bool enabled)
+{
+    d->topologyCache.setEnabled(enabled);
+}
+
+int Client::maxFramesPerRead() const
+{
+    return d->maxFramesPerRead;
+}
+
+void Client::setMaxFramesPerRead(int n)
+{
+    d->maxFramesPerRead = n;
+}
+
+qint64 Client::maxBytesPerRead() const
+{
+    return d->maxBytesPerRead;
+}
+
+void Client::setMaxBytesPerRead(qint64 n)
+{
+    d->maxBytesPerRead = n;
 }
 
 void Client::disconnectFromHost(quint16 code,
@@ -262,24 +837,24 @@ void Client::disconnectFromHost(quint16 code,
         return;
     }
     d->connection->sendClose(code, replyText, classId, methodId);
+    d->startConnectionTimer();
 }
 
 QSharedPointer<Channel> Client::createChannel()
 {
-    const int maxChannelId = d->connection->maxChannelId();
-    for (int i = 0; i < maxChannelId; i++) {
-        const quint16 channelId = d->nextChannelId++;
-        if (d->nextChannelId > maxChannelId) {
-            d->nextChannelId = 1;
-        }
-        if (!d->channels.contains(channelId)) {
-            QSharedPointer<Channel> handler(new Channel(this, channelId));
-            d->channels[channelId] = handler;
-            return handler.staticCast<Channel>();
-        }
+    const quint16 channelId = d->channels.allocate(d->connection->maxChannelId());
+    if (channelId == 0) {
+        qWarning() << "No free channel id available to create channel";
+        return nullptr;
     }
-    qWarning() << "No free channel id available to create channel";
-    return nullptr;
+    QSharedPointer<Channel> handler(new Channel(this, channelId));
+    d->channels.insert(channelId, handler);
+    return handler;
+}
+
+QSharedPointer<Channel> Client::channel(quint16 channelId) const
+{
+    return d->channels.value(channelId);
 }
 
 void Client::onSocketSslErrors(const QList<QSslError> &errors)
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <qtrabbitmq/client.h>
+
+#include "channel_table.h"
+#include "frame_writer.h"
+#include "mpsc_queue.h"
+#include "timer_wheel.h"
+#include "topology_cache.h"
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QSslSocket>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace qmq {
+
+namespace detail {
+class ConnectionHandler;
+
+//! Work queued for the I/O thread by Client::post*().
+struct Submission
+{
+    enum class Kind { None, Publish, Ack, Nack, Reject, Call };
+    Kind kind = Kind::None;
+    quint16 channelId = 0;
+    Message message;
+    PublishOptions publishOptions;
+    quint64 deliveryTag = 0;
+    bool multiple = false;
+    bool requeue = false;
+    std::function<void(Client *)> call;
+};
+} // namespace detail
+
+class Client::Private
+{
+public:
+    explicit Private(Client *_q)
+        : q(_q)
+    {}
+    static Private *get(Client *client) { return client->d.get(); }
+
+    Client *const q;
+
+    QSslSocket *socket = nullptr;
+    QUrl url;
+    QString vhost;
+    QString userName;
+    QString password;
+    QSharedPointer<detail::ConnectionHandler> connection;
+    // Timeouts of the connection and its requests share one wheel, woken by one timer.
+    // Declared before the channels, whose requests hold timer ids.
+    detail::TimerWheel timers;
+    QTimer *timerWheelTimer = nullptr;
+    detail::TimerWheel::TimerId connectionTimer = 0;
+    int connectionTimeoutMs = 30 * 1000;
+    // When data was last read from / written by the socket, on the wheel's clock. Stamped once
+    // per socket read and on QAbstractSocket::bytesWritten, for the heartbeat checks.
+    qint64 lastReadMs = 0;
+    qint64 lastWriteMs = 0;
+    quint32 maxFrameSizeBytes = 1024 * 1024;
+    detail::ChannelTable channels;
+    quint16 maxChannelId = 2047;
+    quint16 heartbeatSeconds = 60;
+    ConnectionState state = ConnectionState::Closed;
+    int rpcTimeoutMs = 60 * 1000;
+    detail::TopologyCache topologyCache;
+
+    // Received bytes; frames are decoded in place from readOffset onwards.
+    QByteArray readBuffer;
+    qsizetype readOffset = 0;
+    // Per-readyRead dispatch budget; 0 means unlimited.
+    int maxFramesPerRead = 512;
+    qint64 maxBytesPerRead = 1024 * 1024;
+    bool drainScheduled = false;
+    // Set after a frame error: input is dropped until the connection is gone.
+    bool discardingInput = false;
+
+    // Outgoing frames are serialized here. commitFrames() writes them to the socket, or in
+    // corked mode defers that to the threshold, the event loop or Client::flush().
+    detail::FrameWriter writer;
+    WriteMode writeMode = WriteMode::Immediate;
+    qint64 flushThresholdBytes = 64 * 1024;
+    bool flushScheduled = false;
+
+    // Outbound backpressure, see Client::isWritable().
+    qint64 highWatermarkBytes = 16 * 1024 * 1024;
+    qint64 lowWatermarkBytes = 4 * 1024 * 1024;
+    BackpressurePolicy backpressurePolicy = BackpressurePolicy::Ignore;
+    qint64 publishQueueLimitBytes = 64 * 1024 * 1024;
+    bool writable = true;
+
+    // connection.blocked from the broker, see Client::isBlocked(). While gated, publishes are
+    // held by their channels; gatedBytes is their total.
+    bool blocked = false;
+    bool publishGating = false;
+    qint64 gatedBytes = 0;
+
+    // See Client::startIoThread().
+    QScopedPointer<QThread> ioThread;
+    std::unique_ptr<detail::MpscQueue<detail::Submission>> submissions;
+    std::atomic<bool> drainPosted{false};
+    // While non-zero, commitFrames() leaves frames in the writer (up to the flush threshold),
+    // so that a burst goes out in one write when the outermost WriteBatch ends.
+    int writeBatchDepth = 0;
+
+    class WriteBatch
+    {
+    public:
+        explicit WriteBatch(Private *_d)
+            : d(_d)
+        {
+            ++d->writeBatchDepth;
+        }
+        ~WriteBatch()
+        {
+            if (--d->writeBatchDepth == 0) {
+                d->endWriteBatch();
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(WriteBatch)
+        Private *const d;
+    };
+
+    void fillReadBuffer();
+    bool commitFrames();
+    bool flushWriter();
+    bool isHoldingFrames() const
+    {
+        return !writable && backpressurePolicy == BackpressurePolicy::Queue;
+    }
+    //! Whether a publish may be added to the writer now, according to the backpressure policy.
+    bool canPublish() const;
+    bool isPublishGated() const { return blocked && publishGating; }
+    qint64 bytesToWrite() const;
+    void updateWritable();
+    void endWriteBatch();
+    void armTimerWheel();
+    //! Aborts the socket unless the connection handshake in progress completes in time.
+    void startConnectionTimer();
+    bool submit(detail::Submission &&submission);
+    void drainSubmissions();
+    void runSubmission(detail::Submission &submission);
+};
+
+} // namespace qmq
@@ -0,0 +1,151 @@
+#include "confirm_tracker.h"
+
+#include <qtrabbitmq/exception.h>
+
+#include <QDebug>
+
+namespace qmq::detail {
+
+void ConfirmTracker::enable()
+{
+    if (m_enabled) {
+        return;
+    }
+    m_enabled = true;
+    m_nextSeqNo = 1;
+    m_firstSeqNo = 1;
+}
+
+quint64 ConfirmTracker::addPublishes(qsizetype count)
+{
+    const quint64 first = m_nextSeqNo;
+    m_pending.resize(m_pending.size() + size_t(count));
+    m_nextSeqNo += quint64(count);
+    return first;
+}
+
+QFuture<void> ConfirmTracker::watch(quint64 firstSeqNo, qsizetype count)
+{
+    const WaiterPtr waiter = makeWaiter(count);
+    for (quint64 seqNo = firstSeqNo; seqNo < firstSeqNo + quint64(count); ++seqNo) {
+        if (seqNo < m_firstSeqNo || seqNo >= m_nextSeqNo
+            || m_pending[size_t(seqNo - m_firstSeqNo)].settled) {
+            // Already confirmed, or never published.
+            --waiter->remaining;
+            continue;
+        }
+        m_pending[size_t(seqNo - m_firstSeqNo)].waiter = waiter;
+    }
+    if (waiter->remaining == 0) {
+        finishWaiter(waiter);
+    }
+    return waiter->promise.future();
+}
+
+QFuture<void> ConfirmTracker::waitForAll()
+{
+    const WaiterPtr waiter = makeWaiter(0);
+    if (m_pending.empty()) {
+        finishWaiter(waiter);
+    } else {
+        m_barriers.push_back({m_nextSeqNo - 1, waiter});
+    }
+    return waiter->promise.future();
+}
+
+void ConfirmTracker::settle(quint64 deliveryTag, bool multiple, bool acked)
+{
+    if (deliveryTag >= m_nextSeqNo) {
+        qWarning() << "Confirm for unknown publish" << deliveryTag;
+        return;
+    }
+    if (multiple) {
+        for (quint64 seqNo = m_firstSeqNo; seqNo <= deliveryTag; ++seqNo) {
+            settleOne(seqNo, acked);
+        }
+    } else if (deliveryTag >= m_firstSeqNo) {
+        settleOne(deliveryTag, acked);
+    }
+    popSettled();
+}
+
+void ConfirmTracker::failAll(int code, const QString &message)
+{
+    if (!m_pending.empty()) {
+        qWarning() << m_pending.size() << "publishes not confirmed:" << message;
+    }
+    const qmq::Exception exc(code, message);
+    for (Entry &entry : m_pending) {
+        if (entry.waiter && !entry.settled && !entry.waiter->promise.future().isFinished()) {
+            entry.waiter->promise.setException(exc);
+            entry.waiter->promise.finish();
+        }
+    }
+    for (Barrier &barrier : m_barriers) {
+        barrier.waiter->promise.setException(exc);
+        barrier.waiter->promise.finish();
+    }
+    m_pending.clear();
+    m_barriers.clear();
+    m_firstSeqNo = m_nextSeqNo;
+}
+
+void ConfirmTracker::reset(int code, const QString &message)
+{
+    failAll(code, message);
+    m_enabled = false;
+    m_nextSeqNo = 1;
+    m_firstSeqNo = 1;
+}
+
+ConfirmTracker::WaiterPtr ConfirmTracker::makeWaiter(qsizetype remaining)
+{
+    WaiterPtr waiter = WaiterPtr::create();
+    waiter->remaining = remaining;
+    waiter->promise.start();
+    return waiter;
+}
+
+void ConfirmTracker::finishWaiter(const WaiterPtr &waiter)
+{
+    if (waiter->nacked) {
+        waiter->promise.setException(qmq::Exception(0, "Publish nacked by broker"));
+    }
+    waiter->promise.finish();
+}
+
+void ConfirmTracker::settleOne(quint64 seqNo, bool acked)
+{
+    Entry &entry = m_pending[size_t(seqNo - m_firstSeqNo)];
+    if (entry.settled) {
+        return;
+    }
+    entry.settled = true;
+    if (!acked) {
+        for (auto it = m_barriers.rbegin(); it != m_barriers.rend() && it->lastSeqNo >= seqNo;
+             ++it) {
+            it->waiter->nacked = true;
+        }
+    }
+    if (entry.waiter) {
+        entry.waiter->nacked = entry.waiter->nacked || !acked;
+        if (--entry.waiter->remaining == 0) {
+            finishWaiter(entry.waiter);
+        }
+        entry.waiter.reset();
+    }
+}
+
+void ConfirmTracker::popSettled()
+{
+    while (!m_pending.empty() && m_pending.front().settled) {
+        m_pending.pop_front();
+        ++m_firstSeqNo;
+    }
+    while (!m_barriers.empty() && m_barriers.front().lastSeqNo < m_firstSeqNo) {
+        finishWaiter(m_barriers.front().waiter);
+        m_barriers.pop_front();
+    }
+}
+
+} // namespace qmq::detail
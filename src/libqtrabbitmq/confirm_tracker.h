@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QFuture>
+#include <QPromise>
+#include <QSharedPointer>
+#include <QString>
+#include <qglobal.h>
+
+#include <deque>
+
+namespace qmq::detail {
+
+//! Publisher confirm bookkeeping for one channel in confirm mode.
+//!
+//! Publishes are numbered from 1 in the order they are sent. Outstanding publishes are kept
+//! in a deque indexed by (seqNo - first outstanding seqNo), so a single ack is O(1) and a
+//! multiple ack settles its range in O(1) amortized per message. Settled publishes are
+//! dropped from the front as soon as everything before them is settled.
+//!
+//! A future can cover one publish, a batch of consecutive publishes, or (waitForAll())
+//! everything published so far. It fails if any publish it covers is nacked.
+class ConfirmTracker
+{
+public:
+    bool isEnabled() const { return m_enabled; }
+    //! Starts numbering at 1; publishes sent before this are not confirmed by the broker.
+    void enable();
+
+    //! Sequence number of the next publish.
+    quint64 nextSeqNo() const { return m_nextSeqNo; }
+    qsizetype outstandingCount() const { return qsizetype(m_pending.size()); }
+
+    //! Registers \a count consecutive publishes and returns the sequence number of the first.
+    quint64 addPublishes(qsizetype count);
+    //! Future that finishes when the \a count publishes from \a firstSeqNo are acked. Meant for
+    //! publishes that were just registered; each publish can be watched by one future.
+    QFuture<void> watch(quint64 firstSeqNo, qsizetype count);
+    //! Finishes when every publish registered so far is settled.
+    QFuture<void> waitForAll();
+
+    //! Handles basic.ack (\a acked) or basic.nack from the broker.
+    void settle(quint64 deliveryTag, bool multiple, bool acked);
+    //! Fails every outstanding future, e.g. when the channel closes.
+    void failAll(int code, const QString &message);
+    //! Fails every outstanding future and leaves confirm mode, as a closed channel does; the
+    //! next enable() numbers publishes from 1 again.
+    void reset(int code, const QString &message);
+
+private:
+    struct Waiter
+    {
+        QPromise<void> promise;
+        qsizetype remaining = 0;
+        bool nacked = false;
+    };
+    using WaiterPtr = QSharedPointer<Waiter>;
+
+    struct Entry
+    {
+        WaiterPtr waiter;
+        bool settled = false;
+    };
+    struct Barrier
+    {
+        quint64 lastSeqNo = 0;
+        WaiterPtr waiter;
+    };
+
+    static WaiterPtr makeWaiter(qsizetype remaining);
+    static void finishWaiter(const WaiterPtr &waiter);
+    void settleOne(quint64 seqNo, bool acked);
+    void popSettled();
+
+    bool m_enabled = false;
+    quint64 m_nextSeqNo = 1;
+    // Sequence number of m_pending.front().
+    quint64 m_firstSeqNo = 1;
+    std::deque<Entry> m_pending;
+    // Sorted by lastSeqNo, as they are created in publish order.
+    std::deque<Barrier> m_barriers;
+};
+
+} // namespace qmq::detail
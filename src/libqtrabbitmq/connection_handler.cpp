@@ -1,5 +1,7 @@
 #include "connection_handler.h"
+#include "client_p.h"
 #include "spec_constants.h"
+#include "spec_methods.h"
 #include <qtrabbitmq/authentication.h>
 #include <qtrabbitmq/client.h>
 
@@ -36,6 +38,10 @@ bool ConnectionHandler::handleMethodFrame(const MethodFrame &frame)
         return this->onClose(frame);
     case spec::connection::CloseOk:
         return this->onCloseOk(frame);
+    case spec::connection::Blocked:
+        return this->onBlocked(frame);
+    case spec::connection::Unblocked:
+        return this->onUnblocked(frame);
     default:
         qWarning() << "Unknown connection frame" << frame.methodId();
         break;
@@ -45,21 +51,21 @@ bool ConnectionHandler::handleMethodFrame(const MethodFrame &frame)
 
 bool ConnectionHandler::handleHeartbeatFrame(const HeartbeatFrame &)
 {
+    // Client::onSocketReadyRead() has noted the read already, as for any other frame.
     qDebug() << "Received heartbeat";
-    this->m_lastheartbeatReceived = QDateTime::currentDateTimeUtc();
     return true;
 }
 
 bool ConnectionHandler::onStart(const MethodFrame &frame)
 {
-    bool isOk = false;
-    const QVariantList args = frame.getArguments(&isOk);
-    if (!isOk) {
+    spec::methods::connection::Start method;
+    if (!decodeMethod(frame, &method)) {
         qWarning() << "Failed to parse args";
         return false;
     }
-    qDebug() << "Start" << args;
-    const QString protocolVersion = QString("%1.%2").arg(args.at(0).toInt()).arg(args.at(1).toInt());
+    qDebug() << "Start" << method.serverProperties << method.mechanisms << method.locales;
+    const QString protocolVersion
+        = QString("%1.%2").arg(method.versionMajor).arg(method.versionMinor);
     qDebug() << "Protocol:" << protocolVersion;
     this->sendStartOk();
     return true;
@@ -70,40 +76,41 @@ bool ConnectionHandler::sendStartOk()
     AmqpPlainAuthenticator auth;
     auth.setUsername(m_client->username().toUtf8());
     auth.setPassword(m_client->password().toUtf8());
-    QVariantHash clientProperties;
-    const QString mechanism = auth.mechanism();
-    const QByteArray response = auth.responseBytes("");
-    const QString locale = "en_US";
-    const QVariantList args({clientProperties, mechanism, response, locale});
-    MethodFrame frame(channel0, spec::connection::ID_, spec::connection::StartOk);
+    spec::methods::connection::StartOk method;
+    // The broker only sends connection.blocked to clients that say they handle it.
+    QVariantHash capabilities;
+    capabilities.insert(QStringLiteral("connection.blocked"), true);
+    method.clientProperties.insert(QStringLiteral("capabilities"), capabilities);
+    method.mechanism = auth.mechanism();
+    method.response = auth.responseBytes("");
+    method.locale = "en_US";
+    const MethodFrame frame = encodeMethod(channel0, method);
     qDebug() << "Sending startOk method frame";
-    frame.setArguments(args);
     return m_client->sendFrame(frame);
 }
 
 bool ConnectionHandler::onTune(const MethodFrame &frame)
 {
-    bool ok = false;
-    const QVariantList args = frame.getArguments(&ok);
-    if (!ok) {
+    spec::methods::connection::Tune method;
+    if (!decodeMethod(frame, &method)) {
         qWarning() << "Failed to parse args";
         return false;
     }
-    qDebug() << "Tune" << args;
+    qDebug() << "Tune" << method.channelMax << method.frameMax << method.heartbeat;
 
-    const quint16 channelMax = args.at(0).toUInt(&ok);
+    const quint16 channelMax = method.channelMax;
     if (channelMax != 0) {
         // zero means no limit is specfied. Choose something.
         this->m_channelMax = std::min(channelMax, this->m_channelMax);
     }
 
-    const quint32 frameMaxSizeBytes = args.at(1).toUInt(&ok);
+    const quint32 frameMaxSizeBytes = method.frameMax;
     if (frameMaxSizeBytes != 0) {
         // zero means no limit is specfied. Chose something.
         this->m_maxFrameSizeBytes = std::min(frameMaxSizeBytes, this->m_maxFrameSizeBytes);
     }
 
-    const quint16 heartbeatSeconds = args.at(2).toUInt(&ok);
+    const quint16 heartbeatSeconds = method.heartbeat;
     if (heartbeatSeconds != 0) {
         // zero means no heartbeat is desired.
         this->m_heartbeatSeconds = std::min(heartbeatSeconds, this->m_heartbeatSeconds);
@@ -123,24 +130,22 @@ bool ConnectionHandler::onTune(const MethodFrame &frame)
 
 bool ConnectionHandler::sendTuneOk()
 {
-    const QVariantList args({QVariant::fromValue(this->m_channelMax),
-                             this->m_maxFrameSizeBytes,
-                             QVariant::fromValue(this->m_heartbeatSeconds)});
-    MethodFrame frame(channel0, spec::connection::ID_, spec::connection::TuneOk);
-    qDebug() << "Set TuneOk method frame args" << args;
-    frame.setArguments(args);
+    spec::methods::connection::TuneOk method;
+    method.channelMax = this->m_channelMax;
+    method.frameMax = this->m_maxFrameSizeBytes;
+    method.heartbeat = this->m_heartbeatSeconds;
+    const MethodFrame frame = encodeMethod(channel0, method);
+    qDebug() << "Set TuneOk method frame args" << method.channelMax << method.frameMax
+             << method.heartbeat;
     return m_client->sendFrame(frame);
 }
 
 bool ConnectionHandler::sendOpen()
 {
-    const QString virtualHost = m_client->virtualHost();
-    const QString reserved1;      // capabilities
-    const bool reserved2 = false; // insist
-    const QVariantList args({virtualHost, reserved1, reserved2});
-    MethodFrame frame(channel0, spec::connection::ID_, spec::connection::Open);
-    qDebug() << "Set open method frame args" << args;
-    frame.setArguments(args);
+    spec::methods::connection::Open method;
+    method.virtualHost = m_client->virtualHost();
+    const MethodFrame frame = encodeMethod(channel0, method);
+    qDebug() << "Set open method frame args" << method.virtualHost;
     return m_client->sendFrame(frame);
 }
 
@@ -154,17 +159,15 @@ bool ConnectionHandler::onOpenOk(const MethodFrame &frame)
 
 bool ConnectionHandler::onClose(const MethodFrame &frame)
 {
-    bool isOk = false;
-    const QVariantList args = frame.getArguments(&isOk);
-    if (!isOk) {
+    spec::methods::connection::Close method;
+    if (!decodeMethod(frame, &method)) {
         qWarning() << "Failed to parse args";
         return false;
     }
-    qDebug() << "Close" << args;
-    m_closeReason.code = args.at(0).value<quint16>();
-    m_closeReason.replyText = args.at(1).toString();
-    m_closeReason.classId = args.at(2).value<quint16>();
-    m_closeReason.methodId = args.at(3).value<quint16>();
+    m_closeReason.code = method.replyCode;
+    m_closeReason.replyText = method.replyText;
+    m_closeReason.classId = method.classId;
+    m_closeReason.methodId = method.methodId;
     m_closeReason.isServerInitiated = true;
     qDebug() << "Received close" << m_closeReason.code << m_closeReason.replyText
              << m_closeReason.classId << m_closeReason.methodId;
@@ -176,6 +179,7 @@ bool ConnectionHandler::sendCloseOk()
 {
     MethodFrame frame(channel0, spec::connection::ID_, spec::connection::CloseOk);
     qDebug() << "Sending CloseOk";
+    this->stopHeartbeat();
     const bool isOk = m_client->sendFrame(frame);
     emit connectionClosed(m_closeReason.code,
                           m_closeReason.replyText,
@@ -195,13 +199,13 @@ bool ConnectionHandler::sendClose(quint16 code,
     m_closeReason.methodId = methodId;
     m_closeReason.isServerInitiated = false;
 
-    const QVariantList args({QVariant::fromValue(code),
-                             replyText,
-                             QVariant::fromValue(classId),
-                             QVariant::fromValue(methodId)});
-    MethodFrame frame(channel0, spec::connection::ID_, spec::connection::Close);
-    qDebug() << "Set connection.close frame args" << args;
-    frame.setArguments(args);
+    spec::methods::connection::Close method;
+    method.replyCode = code;
+    method.replyText = replyText;
+    method.classId = classId;
+    method.methodId = methodId;
+    const MethodFrame frame = encodeMethod(channel0, method);
+    qDebug() << "Set connection.close frame args" << code << replyText << classId << methodId;
     return m_client->sendFrame(frame);
 }
 
@@ -217,49 +221,77 @@ bool ConnectionHandler::onCloseOk(const MethodFrame &frame)
     return true;
 }
 
+bool ConnectionHandler::onBlocked(const MethodFrame &frame)
+{
+    spec::methods::connection::Blocked method;
+    if (!decodeMethod(frame, &method)) {
+        qWarning() << "Failed to parse args";
+        return false;
+    }
+    emit connectionBlocked(method.reason);
+    return true;
+}
+
+bool ConnectionHandler::onUnblocked(const MethodFrame &frame)
+{
+    Q_UNUSED(frame);
+    emit connectionUnblocked();
+    return true;
+}
+
 bool ConnectionHandler::startHeartbeat()
 {
-    this->m_lastheartbeatReceived = QDateTime::currentDateTimeUtc();
+    Client::Private *client = Client::Private::get(m_client);
+    client->lastReadMs = client->lastWriteMs = client->timers.now();
     if (this->m_heartbeatSeconds <= 0) {
         return true;
     }
-    if (this->m_heartbeatTimer == nullptr) {
-        this->m_heartbeatTimer = new QTimer(this);
-        // To help avoid timeouts, we send heartbeats at twice the min.
-        this->m_heartbeatTimer->setInterval(int(this->m_heartbeatSeconds) * (1000 / 2));
-        connect(this->m_heartbeatTimer,
-                &QTimer::timeout,
-                this,
-                &ConnectionHandler::onHeartbeatTimer);
-    }
-    this->m_heartbeatTimer->start();
+    this->scheduleHeartbeatCheck(qint64(this->m_heartbeatSeconds) * 1000 / 2);
     return true;
 }
 
 void ConnectionHandler::stopHeartbeat()
 {
-    if (this->m_heartbeatTimer != nullptr) {
-        this->m_heartbeatTimer->deleteLater();
-        this->m_heartbeatTimer = nullptr;
-    }
+    Client::Private::get(m_client)->timers.cancel(this->m_heartbeatTimer);
+    this->m_heartbeatTimer = 0;
+}
+
+void ConnectionHandler::scheduleHeartbeatCheck(qint64 delayMs)
+{
+    TimerWheel &timers = Client::Private::get(m_client)->timers;
+    timers.cancel(this->m_heartbeatTimer);
+    this->m_heartbeatTimer = timers.start(delayMs, [this]() {
+        this->m_heartbeatTimer = 0;
+        this->onHeartbeatTimer();
+    });
 }
 
 void ConnectionHandler::onHeartbeatTimer()
 {
-    const QDateTime nowUtc = QDateTime::currentDateTimeUtc();
+    Client::Private *client = Client::Private::get(m_client);
+    const qint64 intervalMs = qint64(this->m_heartbeatSeconds) * 1000;
+    const qint64 now = client->timers.now();
     // This follows RabbitMq - "After two missed heartbeats, the peer is considered to be unreachable."
-    if (this->m_lastheartbeatReceived.secsTo(nowUtc) > (this->m_heartbeatSeconds * 2)) {
-        qWarning() << "Missed heartbeats from server: last receieved at"
-                   << this->m_lastheartbeatReceived << "now:" << nowUtc
+    const qint64 silentMs = now - client->lastReadMs;
+    if (silentMs >= intervalMs * 2) {
+        qWarning() << "Missed heartbeats from server: nothing received for" << silentMs << "ms"
                    << "heartbeat:" << this->m_heartbeatSeconds << "s";
         this->m_client->disconnectFromHost(500, "Missed heartbeats");
+        return;
+    }
+    // To help avoid timeouts, the server hears from us at least twice per interval; any frame
+    // will do, so a heartbeat is only sent when nothing else was written meanwhile. Frames
+    // still in the writer do not count: with BackpressurePolicy::Queue they may stay there.
+    const qint64 sendIntervalMs = intervalMs / 2;
+    qint64 lastWrite = client->lastWriteMs;
+    if (now - lastWrite >= sendIntervalMs) {
+        this->m_client->sendHeartbeat();
+        lastWrite = now;
     }
-    this->m_client->sendHeartbeat();
+    const qint64 nextSend = lastWrite + sendIntervalMs;
+    const qint64 nextMissed = client->lastReadMs + intervalMs * 2;
+    this->scheduleHeartbeatCheck(qMax<qint64>(qMin(nextSend, nextMissed) - now, 1));
 }
 
-void ConnectionHandler::resetTrafficFromServerHeartbeat()
-{
-    this->m_lastheartbeatReceived = QDateTime::currentDateTimeUtc();
-}
 } // namespace detail
 } // namespace qmq
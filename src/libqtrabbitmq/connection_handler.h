@@ -3,9 +3,9 @@
 #include "qtrabbitmq/abstract_frame_handler.h"
 #include "qtrabbitmq/client.h"
 
-#include <QDateTime>
+#include "timer_wheel.h"
+
 #include <QObject>
-#include <QTimer>
 #include <qglobal.h>
 
 namespace qmq {
@@ -31,10 +31,10 @@ public:
     quint16 heartbeatSeconds() const { return m_heartbeatSeconds; }
     void setTuneParameters(quint16 channelMax, quint32 maxFrameSizeBytes, quint16 heartbeatSeconds);
 
-    // Any valid traffic from the server counts as a heartbeat.
-    void resetTrafficFromServerHeartbeat();
 Q_SIGNALS:
     void connectionOpened();
+    void connectionBlocked(const QString &reason);
+    void connectionUnblocked();
     void connectionClosed(quint16 code, const QString &replyText, quint16 classId, quint16 methodId);
 
 protected:
@@ -48,18 +48,20 @@ protected:
     bool startHeartbeat();
     void stopHeartbeat();
     void onHeartbeatTimer();
+    void scheduleHeartbeatCheck(qint64 delayMs);
 
 private:
     bool onStart(const MethodFrame &frame);
     bool onTune(const MethodFrame &frame);
     bool onCloseOk(const MethodFrame &frame);
+    bool onBlocked(const MethodFrame &frame);
+    bool onUnblocked(const MethodFrame &frame);
 
     Client *m_client = nullptr;
-    QTimer *m_heartbeatTimer = nullptr;
+    TimerWheel::TimerId m_heartbeatTimer = 0;
     quint16 m_channelMax = 2047;
     quint32 m_maxFrameSizeBytes = 131072;
     quint16 m_heartbeatSeconds = 60;
-    QDateTime m_lastheartbeatReceived;
     Client::ConnectionState m_state = Client::ConnectionState::Closed;
 
     struct CloseArgs
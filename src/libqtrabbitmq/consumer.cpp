@@ -1,6 +1,7 @@
 #include <qtrabbitmq/consumer.h>
 
 #include <QQueue>
+#include <QTimer>
 #include <QUuid>
 
 #include <qtrabbitmq/channel.h>
@@ -11,6 +12,14 @@ class Consumer::Private
 public:
     QString consumerTag;
     QQueue<qmq::Message> messageQueue;
+
+    DeliveryMode deliveryMode = DeliveryMode::PerMessage;
+    int batchMaxMessages = 256;
+    int batchMaxDelayMs = 0;
+    // Messages queued since the last messagesReady().
+    int unsignalledCount = 0;
+    QTimer batchTimer;
+    Handler handler;
 };
 
 Consumer::Consumer(const QString &consumerTag, QObject *parent)
@@ -21,6 +30,15 @@ Consumer::Consumer(const QString &consumerTag, QObject *parent)
     if (d->consumerTag.isEmpty()) {
         d->consumerTag = QUuid::createUuid().toString(QUuid::StringFormat::WithoutBraces);
     }
+    // A zero interval timer fires once the current socket read has been dispatched.
+    d->batchTimer.setSingleShot(true);
+    connect(&d->batchTimer, &QTimer::timeout, this, [this]() {
+        const int count = d->unsignalledCount;
+        d->unsignalledCount = 0;
+        if (count > 0) {
+            emit this->messagesReady(count);
+        }
+    });
 }
 
 Consumer::~Consumer() = default;
@@ -30,10 +48,73 @@ QString Consumer::consumerTag() const
     return d->consumerTag;
 }
 
+Consumer::DeliveryMode Consumer::deliveryMode() const
+{
+    return d->deliveryMode;
+}
+
+void Consumer::setDeliveryMode(DeliveryMode mode)
+{
+    d->deliveryMode = mode;
+}
+
+int Consumer::batchMaxMessages() const
+{
+    return d->batchMaxMessages;
+}
+
+void Consumer::setBatchMaxMessages(int n)
+{
+    d->batchMaxMessages = n;
+}
+
+int Consumer::batchMaxDelayMs() const
+{
+    return d->batchMaxDelayMs;
+}
+
+void Consumer::setBatchMaxDelayMs(int ms)
+{
+    d->batchMaxDelayMs = ms;
+}
+
+void Consumer::setHandler(Handler handler)
+{
+    d->handler = std::move(handler);
+}
+
+bool Consumer::hasHandler() const
+{
+    return bool(d->handler);
+}
+
+const Consumer::Handler &Consumer::handler() const
+{
+    return d->handler;
+}
+
 void Consumer::pushMessage(const qmq::Message &msg)
 {
-    d->messageQueue.enqueue(msg);
-    emit this->messageReady();
+    pushMessage(qmq::Message(msg));
+}
+
+void Consumer::pushMessage(qmq::Message &&msg)
+{
+    d->messageQueue.enqueue(std::move(msg));
+    if (d->deliveryMode == DeliveryMode::PerMessage) {
+        emit this->messageReady();
+        return;
+    }
+
+    ++d->unsignalledCount;
+    if (d->unsignalledCount >= qMax(d->batchMaxMessages, 1)) {
+        d->batchTimer.stop();
+        const int count = d->unsignalledCount;
+        d->unsignalledCount = 0;
+        emit this->messagesReady(count);
+    } else if (!d->batchTimer.isActive()) {
+        d->batchTimer.start(qMax(d->batchMaxDelayMs, 0));
+    }
 }
 
 bool Consumer::hasMessage() const
@@ -41,6 +122,11 @@ bool Consumer::hasMessage() const
     return !d->messageQueue.isEmpty();
 }
 
+int Consumer::messageCount() const
+{
+    return int(d->messageQueue.size());
+}
+
 QFuture<QString> Consumer::consume(Channel *channel, const QString &queueName)
 {
     channel->addConsumer(this);
@@ -51,4 +137,20 @@ Message Consumer::dequeueMessage()
 {
     return d->messageQueue.dequeue();
 }
-} // namespace qmq
\ No newline at end of file
+
+QList<Message> Consumer::dequeueBatch(int maxCount)
+{
+    if (maxCount < 0 || maxCount >= d->messageQueue.size()) {
+        QList<Message> batch = std::move(d->messageQueue);
+        d->messageQueue.clear();
+        return batch;
+    }
+    QList<Message> batch;
+    batch.reserve(maxCount);
+    for (int i = 0; i < maxCount; ++i) {
+        batch.append(std::move(d->messageQueue[i]));
+    }
+    d->messageQueue.remove(0, maxCount);
+    return batch;
+}
+} // namespace qmq
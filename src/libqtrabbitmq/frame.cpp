@@ -1,3 +1,7 @@
+#include "amqp_codec.h"
+#include "byte_cursor.h"
+#include "byte_writer.h"
+#include "frame_writer.h"
 #include "spec_constants.h"
 #include <qtrabbitmq/frame.h>
 
@@ -10,6 +14,7 @@
 #include <QtEndian>
 
 #include <array>
+#include <limits>
 namespace {
 bool verifyTypeCompat(const qmq::FieldValue type, const QMetaType &metatype)
 {
@@ -60,8 +65,8 @@ bool verifyTypeCompat(const qmq::FieldValue type, const QMetaType &metatype)
     // Unreachable
     return false;
 }
-template<typename T>
-T readAmqp(QIODevice *io, bool *ok)
+template<typename T, typename Input>
+T readAmqp(Input *io, bool *ok)
 {
     const int N = sizeof(T);
     std::array<char, N> buffer;
@@ -77,8 +82,8 @@ T readAmqp(QIODevice *io, bool *ok)
     return qFromBigEndian<T>(buffer.data());
 }
 
-template<typename T>
-QVariant readAmqpVariant(QIODevice *io, bool *ok)
+template<typename T, typename Input>
+QVariant readAmqpVariant(Input *io, bool *ok)
 {
     bool isOk = false;
     const T value = readAmqp<T>(io, &isOk);
@@ -94,8 +99,8 @@ QVariant readAmqpVariant(QIODevice *io, bool *ok)
     return QVariant();
 }
 
-template<typename T>
-bool writeAmqp(QIODevice *io, T value)
+template<typename T, typename Output>
+bool writeAmqp(Output *io, T value)
 {
     const int N = sizeof(T);
     std::array<char, N> buffer;
@@ -107,8 +112,8 @@ bool writeAmqp(QIODevice *io, T value)
     return true;
 }
 
-template<typename T>
-bool writeAmqpVariant(QIODevice *io, const QVariant &value)
+template<typename T, typename Output>
+bool writeAmqpVariant(Output *io, const QVariant &value)
 {
     if (!value.canConvert<T>()) {
         qCritical() << "Cannot convert value to T";
@@ -117,7 +122,8 @@ bool writeAmqpVariant(QIODevice *io, const QVariant &value)
     return writeAmqp<T>(io, value.value<T>());
 }
 
-bool readAmqpBool(QIODevice *io, bool *ok)
+template<typename Input>
+bool readAmqpBool(Input *io, bool *ok)
 {
     std::array<char, 1> buffer;
     if (io->read(buffer.data(), 1) != 1) {
@@ -132,12 +138,14 @@ bool readAmqpBool(QIODevice *io, bool *ok)
     return buffer[0] != 0;
 }
 
-bool writeAmqpBool(QIODevice *io, bool value)
+template<typename Output>
+bool writeAmqpBool(Output *io, bool value)
 {
     return writeAmqp<quint8>(io, value ? quint8(1) : quint8(0));
 }
 
-QVariant readAmqpVariantBool(QIODevice *io, bool *ok)
+template<typename Input>
+QVariant readAmqpVariantBool(Input *io, bool *ok)
 {
     bool isOk;
     const bool v = readAmqpBool(io, &isOk);
@@ -150,7 +158,8 @@ QVariant readAmqpVariantBool(QIODevice *io, bool *ok)
     return QVariant();
 }
 
-qmq::Decimal readAmqpDecimal(QIODevice *io, bool *ok)
+template<typename Input>
+qmq::Decimal readAmqpDecimal(Input *io, bool *ok)
 {
     std::array<char, 5> buffer;
     if (io->read(buffer.data(), buffer.size()) != buffer.size()) {
@@ -168,12 +177,14 @@ qmq::Decimal readAmqpDecimal(QIODevice *io, bool *ok)
     return qmq::Decimal(scale, value);
 }
 
-bool writeAmqpDecimal(QIODevice *io, const qmq::Decimal &value)
+template<typename Output>
+bool writeAmqpDecimal(Output *io, const qmq::Decimal &value)
 {
     return writeAmqp<quint8>(io, quint8(value.scale)) && writeAmqp<qint32>(io, qint32(value.value));
 }
 
-QVariant readAmqpVariantDecimal(QIODevice *io, bool *ok)
+template<typename Input>
+QVariant readAmqpVariantDecimal(Input *io, bool *ok)
 {
     bool isOk;
     const qmq::Decimal v = readAmqpDecimal(io, &isOk);
@@ -186,7 +197,8 @@ QVariant readAmqpVariantDecimal(QIODevice *io, bool *ok)
     return QVariant();
 }
 
-bool writeAmqpVariantDecimal(QIODevice *io, const QVariant &value)
+template<typename Output>
+bool writeAmqpVariantDecimal(Output *io, const QVariant &value)
 {
     if (!value.canConvert<qmq::Decimal>()) {
         qWarning() << "Cannot convert to decimal";
@@ -195,7 +207,8 @@ bool writeAmqpVariantDecimal(QIODevice *io, const QVariant &value)
     return writeAmqpDecimal(io, value.value<qmq::Decimal>());
 }
 
-QByteArray readAmqpShortString(QIODevice *io, bool *ok)
+template<typename Input>
+QByteArray readAmqpShortString(Input *io, bool *ok)
 {
     bool isOk;
     const quint8 len = readAmqp<quint8>(io, &isOk);
@@ -222,7 +235,8 @@ QByteArray readAmqpShortString(QIODevice *io, bool *ok)
     return buffer;
 }
 
-bool writeAmqpShortString(QIODevice *io, const QByteArray &value)
+template<typename Output>
+bool writeAmqpShortString(Output *io, const QByteArray &value)
 {
     if (value.size() > 0xFF) {
         qWarning() << "string too long";
@@ -240,12 +254,14 @@ bool writeAmqpShortString(QIODevice *io, const QByteArray &value)
     return true;
 }
 
-bool writeAmqpShortString(QIODevice *io, const QString &value)
+template<typename Output>
+bool writeAmqpShortString(Output *io, const QString &value)
 {
     return writeAmqpShortString(io, value.toUtf8());
 }
 
-QVariant readAmqpVariantShortString(QIODevice *io, bool *ok)
+template<typename Input>
+QVariant readAmqpVariantShortString(Input *io, bool *ok)
 {
     bool isOk;
     const QByteArray v = readAmqpShortString(io, &isOk);
@@ -258,7 +274,8 @@ QVariant readAmqpVariantShortString(QIODevice *io, bool *ok)
     return QVariant();
 }
 
-bool writeAmqpVariantShortString(QIODevice *io, const QVariant &value)
+template<typename Output>
+bool writeAmqpVariantShortString(Output *io, const QVariant &value)
 {
     if (value.typeId() == QMetaType::Type::QString) {
         return writeAmqpShortString(io, value.value<QString>());
@@ -270,7 +287,8 @@ bool writeAmqpVariantShortString(QIODevice *io, const QVariant &value)
     return false;
 }
 
-QByteArray readAmqpLongString(QIODevice *io, bool *ok)
+template<typename Input>
+QByteArray readAmqpLongString(Input *io, bool *ok)
 {
     char lenBuf[4];
     if (io->read(static_cast<char *>(lenBuf), 4) != 4) {
@@ -296,7 +314,8 @@ QByteArray readAmqpLongString(QIODevice *io, bool *ok)
     return buffer;
 }
 
-bool writeAmqpLongString(QIODevice *io, const QByteArray &value)
+template<typename Output>
+bool writeAmqpLongString(Output *io, const QByteArray &value)
 {
     const quint32 len = value.size();
     if (value.size() != len) {
@@ -315,7 +334,8 @@ bool writeAmqpLongString(QIODevice *io, const QByteArray &value)
     return true;
 }
 
-QVariant readAmqpVariantLongString(QIODevice *io, bool *ok)
+template<typename Input>
+QVariant readAmqpVariantLongString(Input *io, bool *ok)
 {
     bool isOk;
     const QByteArray v = readAmqpLongString(io, &isOk);
@@ -328,7 +348,8 @@ QVariant readAmqpVariantLongString(QIODevice *io, bool *ok)
     return QVariant();
 }
 
-bool writeAmqpVariantLongString(QIODevice *io, const QVariant &value)
+template<typename Output>
+bool writeAmqpVariantLongString(Output *io, const QVariant &value)
 {
     if (value.typeId() == QMetaType::Type::QByteArray) {
         return writeAmqpLongString(io, value.value<QByteArray>());
@@ -343,72 +364,136 @@ bool writeAmqpVariantLongString(QIODevice *io, const QVariant &value)
     return false;
 }
 
-QVariantList readAmqpVariantFieldArray(QIODevice *io, bool *ok)
+//! Runs \a fn over the next \a len bytes of \a io as a separate reader.
+template<typename Fn>
+bool readPacked(QIODevice *io, quint32 len, Fn fn)
 {
-    bool isOk = true;
-    const quint32 len = readAmqp<quint32>(io, &isOk);
-    if (!isOk) {
-        if (ok != nullptr) {
-            *ok = false;
+    // A QBuffer already holds the data contiguously: parse it in place and seek past it.
+    if (auto *buffer = qobject_cast<QBuffer *>(io); buffer != nullptr) {
+        const qint64 pos = buffer->pos();
+        const QByteArray &data = buffer->data();
+        if (len > data.size() - pos) {
+            qWarning() << "Packed data exceeds available bytes" << len;
+            return false;
         }
-        return QVariantList();
+        qmq::detail::ByteCursor packedIo(data.constData() + pos, qsizetype(len));
+        return fn(&packedIo) && buffer->seek(pos + len);
     }
     QByteArray packedData = io->read(len);
     if (packedData.size() != len) {
-        if (ok != nullptr) {
-            *ok = false;
-        }
         qWarning() << "Attempt to allocate failed" << len;
-        return QVariantList();
+        return false;
     }
     QBuffer packedIo(&packedData);
     if (!packedIo.open(QIODevice::ReadOnly)) {
         qWarning() << "Attempt to open buffer failed";
+        return false;
+    }
+    return fn(&packedIo);
+}
+
+//! In-place variant: the nested reader is a sub-range of the same buffer, nothing is copied.
+template<typename Fn>
+bool readPacked(qmq::detail::ByteCursor *io, quint32 len, Fn fn)
+{
+    qmq::detail::ByteCursor packedIo(nullptr, 0);
+    if (!io->subCursor(len, &packedIo)) {
+        qWarning() << "Packed data exceeds available bytes" << len;
+        return false;
+    }
+    return fn(&packedIo);
+}
+
+//! Writes a 32-bit length followed by whatever \a fn writes. The length is reserved up front
+//! and patched afterwards, so nested tables and arrays are encoded in place.
+template<typename Fn>
+bool writePacked(qmq::detail::ByteWriter *io, Fn fn)
+{
+    const qsizetype lenPos = io->size();
+    writeAmqp<quint32>(io, 0);
+    if (!fn(io)) {
+        io->truncate(lenPos);
+        return false;
+    }
+    const qsizetype len = io->size() - lenPos - qsizetype(sizeof(quint32));
+    if (len > qsizetype(std::numeric_limits<quint32>::max())) {
+        qWarning() << "Packed data too long" << len;
+        io->truncate(lenPos);
+        return false;
+    }
+    io->patch<quint32>(lenPos, quint32(len));
+    return true;
+}
+
+//! A device cannot be patched, so the outermost table or array is encoded into one buffer and
+//! written out; anything nested inside it is still encoded in place.
+template<typename Fn>
+bool writePacked(QIODevice *io, Fn fn)
+{
+    QByteArray packedBuffer;
+    qmq::detail::ByteWriter packedIo(&packedBuffer);
+    if (!writePacked(&packedIo, fn)) {
+        return false;
+    }
+    return io->write(packedBuffer) == packedBuffer.size();
+}
+
+template<typename Input>
+QVariant readFieldValueImpl(Input *io, bool *ok);
+template<typename Input>
+QVariant readNativeFieldValueImpl(Input *io, qmq::FieldValue type, bool *ok);
+
+template<typename Input>
+QVariantList readAmqpVariantFieldArray(Input *io, bool *ok)
+{
+    bool isOk = true;
+    const quint32 len = readAmqp<quint32>(io, &isOk);
+    if (!isOk) {
+        if (ok != nullptr) {
+            *ok = false;
+        }
         return QVariantList();
     }
     QVariantList items;
-    while (!packedIo.atEnd()) {
-        const QVariant nextItem = qmq::Frame::readFieldValue(&packedIo, &isOk);
-        if (!isOk) {
-            if (ok != nullptr) {
-                *ok = false;
+    isOk = readPacked(io, len, [&items](auto *packedIo) {
+        bool itemOk = true;
+        while (!packedIo->atEnd()) {
+            const QVariant nextItem = readFieldValueImpl(packedIo, &itemOk);
+            if (!itemOk) {
+                return false;
             }
-            return items;
+            items.append(nextItem);
         }
-        items.append(nextItem);
+        return true;
+    });
+    if (ok != nullptr) {
+        *ok = isOk;
     }
     return items;
 }
 
-bool writeAmqpFieldArray(QIODevice *io, const QVariantList &value)
-{
-    QByteArray packedBuffer;
-    {
-        QBuffer packedIo(&packedBuffer);
-        if (!packedIo.open(QIODevice::WriteOnly)) {
-            qWarning() << "Failed to open";
-            return false;
-        }
+template<typename Output>
+bool writeFieldValueImpl(Output *io, const QVariant &value);
+template<typename Output>
+bool writeFieldValueImpl(Output *io, const QVariant &value, qmq::FieldValue valueType);
+template<typename Output>
+bool writeNativeFieldValueImpl(Output *io, const QVariant &value, qmq::FieldValue valueType);
 
+template<typename Output>
+bool writeAmqpFieldArray(Output *io, const QVariantList &value)
+{
+    return writePacked(io, [&value](qmq::detail::ByteWriter *packedIo) {
         for (const QVariant &item : value) {
-            const bool isOk = qmq::Frame::writeFieldValue(&packedIo, item);
-            if (!isOk) {
+            if (!writeFieldValueImpl(packedIo, item)) {
                 return false;
             }
         }
-    }
-    const quint32 len = packedBuffer.size();
-    const bool isOk = writeAmqp<quint32>(io, len);
-    if (!isOk)
-        return false;
-    if (!io->write(packedBuffer)) {
-        return false;
-    }
-
-    return true;
+        return true;
+    });
 }
 
-bool writeAmqpVariantFieldArray(QIODevice *io, const QVariant &value)
+template<typename Output>
+bool writeAmqpVariantFieldArray(Output *io, const QVariant &value)
 {
     if (!value.canConvert<QVariantList>()) {
         qWarning() << "Cannot convert to QVariantList";
@@ -417,13 +502,15 @@ bool writeAmqpVariantFieldArray(QIODevice *io, const QVariant &value)
     return writeAmqpFieldArray(io, value.toList());
 }
 
-bool writeAmqpTimestamp(QIODevice *io, const QDateTime &value)
+template<typename Output>
+bool writeAmqpTimestamp(Output *io, const QDateTime &value)
 {
     const qint64 secsSinceEpoch = value.toSecsSinceEpoch();
     return writeAmqp<qint64>(io, secsSinceEpoch);
 }
 
-bool writeAmqpVariantTimestamp(QIODevice *io, const QVariant &value)
+template<typename Output>
+bool writeAmqpVariantTimestamp(Output *io, const QVariant &value)
 {
     if (!value.canConvert<QDateTime>()) {
         qWarning() << "Cannot convert to QDateTime";
@@ -432,7 +519,8 @@ bool writeAmqpVariantTimestamp(QIODevice *io, const QVariant &value)
     return writeAmqpTimestamp(io, value.toDateTime());
 }
 
-QVariantHash readAmqpVariantFieldTable(QIODevice *io, bool *ok)
+template<typename Input>
+QVariantHash readAmqpVariantFieldTable(Input *io, bool *ok)
 {
     bool isOk = true;
     const quint32 len = readAmqp<quint32>(io, &isOk);
@@ -442,74 +530,46 @@ QVariantHash readAmqpVariantFieldTable(QIODevice *io, bool *ok)
         }
         return QVariantHash();
     }
-    QByteArray packedData = io->read(len);
-    if (packedData.size() != len) {
-        if (ok != nullptr) {
-            *ok = false;
-        }
-        qWarning() << "Attempt to allocate failed" << len;
-        return QVariantHash();
-    }
-    QBuffer packedIo(&packedData);
-    if (!packedIo.open(QIODevice::ReadOnly)) {
-        qWarning() << "Attempt to open buffer failed";
-        return QVariantHash();
-    }
     QVariantHash items;
-    while (!packedIo.atEnd()) {
-        const QByteArray name = readAmqpShortString(&packedIo, &isOk);
-        if (!isOk) {
-            if (ok != nullptr) {
-                *ok = false;
+    isOk = readPacked(io, len, [&items](auto *packedIo) {
+        bool itemOk = true;
+        while (!packedIo->atEnd()) {
+            const QByteArray name = readAmqpShortString(packedIo, &itemOk);
+            if (!itemOk) {
+                return false;
             }
-            return items;
-        }
-        const QVariant nextItem = qmq::Frame::readFieldValue(&packedIo, &isOk);
-        if (!isOk) {
-            if (ok != nullptr) {
-                *ok = false;
+            const QVariant nextItem = readFieldValueImpl(packedIo, &itemOk);
+            if (!itemOk) {
+                return false;
             }
-            return items;
+            items[QString::fromUtf8(name)] = nextItem;
         }
-        items[QString::fromUtf8(name)] = nextItem;
+        return true;
+    });
+    if (ok != nullptr) {
+        *ok = isOk;
     }
     return items;
 }
 
-bool writeAmqpFieldTable(QIODevice *io, const QVariantHash &value)
+template<typename Output>
+bool writeAmqpFieldTable(Output *io, const QVariantHash &value)
 {
-    QByteArray packedBuffer;
-    {
-        QBuffer packedIo(&packedBuffer);
-        if (!packedIo.open(QIODevice::WriteOnly)) {
-            qWarning() << "Failed to open";
-            return false;
-        }
-
+    return writePacked(io, [&value](qmq::detail::ByteWriter *packedIo) {
         for (auto it = value.constKeyValueBegin(); it != value.constKeyValueEnd(); ++it) {
-            bool isOk = writeAmqpShortString(&packedIo, it->first);
-            if (!isOk) {
+            if (!writeAmqpShortString(packedIo, it->first)) {
                 return false;
             }
-            isOk = qmq::Frame::writeFieldValue(&packedIo, it->second);
-            if (!isOk) {
+            if (!writeFieldValueImpl(packedIo, it->second)) {
                 return false;
             }
         }
-    }
-    const quint32 len = packedBuffer.size();
-    const bool isOk = writeAmqp<quint32>(io, len);
-    if (!isOk) {
-        return false;
-    }
-
-    if (io->write(packedBuffer) != packedBuffer.size()) {
-        return false;
-    }
-    return true;
+        return true;
+    });
 }
 
-bool writeAmqpVariantFieldTable(QIODevice *io, const QVariant &value)
+template<typename Output>
+bool writeAmqpVariantFieldTable(Output *io, const QVariant &value)
 {
     if (!value.canConvert<QVariantHash>()) {
         qWarning() << "Cannot convert to QVariantHash";
@@ -518,151 +578,55 @@ bool writeAmqpVariantFieldTable(QIODevice *io, const QVariant &value)
     return writeAmqpFieldTable(io, value.toHash());
 }
 
-} // namespace
-
-qmq::FieldValue qmq::Frame::metatypeToFieldValue(int typeId)
-{
-    switch (typeId) {
-    case QMetaType::Type::Bool:
-        return qmq::FieldValue::Boolean;
-    case QMetaType::Type::Char:
-        return qmq::FieldValue::ShortShortInt;
-    case QMetaType::Type::UChar:
-        return qmq::FieldValue::ShortShortUint;
-    case QMetaType::Type::Short:
-        return qmq::FieldValue::ShortInt;
-    case QMetaType::Type::UShort:
-        return qmq::FieldValue::ShortUint;
-    case QMetaType::Type::Int:
-        return qmq::FieldValue::LongInt;
-    case QMetaType::Type::UInt:
-        return qmq::FieldValue::LongUint;
-    case QMetaType::Type::LongLong:
-        return qmq::FieldValue::LongLongInt;
-    case QMetaType::Type::ULongLong:
-        return qmq::FieldValue::LongLongUint;
-    case QMetaType::Type::Float:
-        return qmq::FieldValue::Float;
-    case QMetaType::Type::Double:
-        return qmq::FieldValue::Double;
-    // Decimal is handled later because the value isn't a compile-time constant
-    case QMetaType::Type::QString:
-        return qmq::FieldValue::ShortString;
-    case QMetaType::Type::QByteArray:
-        return qmq::FieldValue::LongString;
-    case QMetaType::Type::QVariantList:
-        return qmq::FieldValue::FieldArray;
-    case QMetaType::Type::QDateTime:
-        return qmq::FieldValue::Timestamp;
-    case QMetaType::Type::QVariantHash:
-        return qmq::FieldValue::FieldTable;
-    case QMetaType::Type::Void:
-        return qmq::FieldValue::Void;
-    default:
-        break;
-    }
-    if (typeId == qMetaTypeId<qmq::Decimal>()) {
-        return qmq::FieldValue::DecimalValue;
-    }
-    return qmq::FieldValue::Invalid;
-}
-
-QMetaType::Type qmq::Frame::fieldValueToMetatype(qmq::FieldValue fieldtype)
-{
-    switch (fieldtype) {
-    case qmq::FieldValue::Bit:
-        Q_FALLTHROUGH();
-    case qmq::FieldValue::Boolean:
-        return QMetaType::Type::Bool;
-    case qmq::FieldValue::ShortShortInt:
-        return QMetaType::Type::Char;
-    case qmq::FieldValue::ShortShortUint:
-        return QMetaType::Type::UChar;
-    case qmq::FieldValue::ShortInt:
-        return QMetaType::Type::Short;
-    case qmq::FieldValue::ShortUint:
-        return QMetaType::Type::UShort;
-    case qmq::FieldValue::LongInt:
-        return QMetaType::Type::Int;
-    case qmq::FieldValue::LongUint:
-        return QMetaType::Type::UInt;
-    case qmq::FieldValue::LongLongInt:
-        return QMetaType::Type::LongLong;
-    case qmq::FieldValue::LongLongUint:
-        return QMetaType::Type::ULongLong;
-    case qmq::FieldValue::Float:
-        return QMetaType::Type::Float;
-    case qmq::FieldValue::Double:
-        return QMetaType::Type::Double;
-    case qmq::FieldValue::DecimalValue:
-        return static_cast<QMetaType::Type>(qMetaTypeId<qmq::Decimal>());
-    case qmq::FieldValue::ShortString:
-        return QMetaType::Type::QString;
-    case qmq::FieldValue::LongString:
-        return QMetaType::Type::QByteArray;
-    case qmq::FieldValue::FieldArray:
-        return QMetaType::Type::QVariantList;
-    case qmq::FieldValue::Timestamp:
-        return QMetaType::Type::QDateTime;
-    case qmq::FieldValue::FieldTable:
-        return QMetaType::Type::QVariantHash;
-    case qmq::FieldValue::Void:
-        return QMetaType::Type::Void;
-    case qmq::FieldValue::Invalid:
-        return QMetaType::Type::UnknownType;
-    default:
-        qCritical() << "Bad Fieldtype" << (int) fieldtype;
-        return QMetaType::Type::UnknownType;
-    }
-}
-
-QVariant qmq::Frame::readFieldValue(QIODevice *io, bool *ok)
+template<typename Input>
+QVariant readFieldValueImpl(Input *io, bool *ok)
 {
     bool isOk;
-    const FieldValue type = static_cast<FieldValue>(readAmqp<quint8>(io, &isOk));
+    const qmq::FieldValue type = static_cast<qmq::FieldValue>(readAmqp<quint8>(io, &isOk));
     if (!isOk) {
         if (ok != nullptr) {
             *ok = false;
         }
         return QVariant();
     }
-    return readNativeFieldValue(io, type, ok);
+    return readNativeFieldValueImpl(io, type, ok);
 }
 
-QVariant qmq::Frame::readNativeFieldValue(QIODevice *io, FieldValue type, bool *ok)
+template<typename Input>
+QVariant readNativeFieldValueImpl(Input *io, qmq::FieldValue type, bool *ok)
 {
     switch (type) {
-    case FieldValue::Boolean:
+    case qmq::FieldValue::Boolean:
         return readAmqpVariantBool(io, ok);
-    case FieldValue::ShortShortInt:
+    case qmq::FieldValue::ShortShortInt:
         return readAmqpVariant<qint8>(io, ok);
-    case FieldValue::ShortShortUint:
+    case qmq::FieldValue::ShortShortUint:
         return readAmqpVariant<quint8>(io, ok);
-    case FieldValue::ShortInt:
+    case qmq::FieldValue::ShortInt:
         return readAmqpVariant<qint16>(io, ok);
-    case FieldValue::ShortUint:
+    case qmq::FieldValue::ShortUint:
         return readAmqpVariant<quint16>(io, ok);
-    case FieldValue::LongInt:
+    case qmq::FieldValue::LongInt:
         return readAmqpVariant<qint32>(io, ok);
-    case FieldValue::LongUint:
+    case qmq::FieldValue::LongUint:
         return readAmqpVariant<quint32>(io, ok);
-    case FieldValue::LongLongInt:
+    case qmq::FieldValue::LongLongInt:
         return readAmqpVariant<qint64>(io, ok);
-    case FieldValue::LongLongUint:
+    case qmq::FieldValue::LongLongUint:
         return readAmqpVariant<quint64>(io, ok);
-    case FieldValue::Float:
+    case qmq::FieldValue::Float:
         return readAmqpVariant<float>(io, ok);
-    case FieldValue::Double:
+    case qmq::FieldValue::Double:
         return readAmqpVariant<double>(io, ok);
-    case FieldValue::DecimalValue:
+    case qmq::FieldValue::DecimalValue:
         return readAmqpVariantDecimal(io, ok);
-    case FieldValue::ShortString:
+    case qmq::FieldValue::ShortString:
         return readAmqpVariantShortString(io, ok);
-    case FieldValue::LongString:
+    case qmq::FieldValue::LongString:
         return readAmqpVariantLongString(io, ok);
-    case FieldValue::FieldArray:
+    case qmq::FieldValue::FieldArray:
         return readAmqpVariantFieldArray(io, ok);
-    case FieldValue::Timestamp: {
+    case qmq::FieldValue::Timestamp: {
         bool isOk = false;
         const qint64 v = readAmqp<qint64>(io, &isOk);
         if (ok != nullptr) {
@@ -673,9 +637,9 @@ QVariant qmq::Frame::readNativeFieldValue(QIODevice *io, FieldValue type, bool *
         }
         return QVariant();
     }
-    case FieldValue::FieldTable:
+    case qmq::FieldValue::FieldTable:
         return readAmqpVariantFieldTable(io, ok);
-    case FieldValue::Void:
+    case qmq::FieldValue::Void:
         if (ok != nullptr) {
             *ok = true;
         }
@@ -688,20 +652,19 @@ QVariant qmq::Frame::readNativeFieldValue(QIODevice *io, FieldValue type, bool *
     }
 }
 
-QVariantList qmq::Frame::readNativeFieldValues(QIODevice *io,
-                                               const QList<FieldValue> &types,
-                                               bool *ok)
+template<typename Input>
+QVariantList readNativeFieldValuesImpl(Input *io, const QList<qmq::FieldValue> &types, bool *ok)
 {
     bool isOk = true;
     int bitPos = 0;
     QVariantList ret;
     ret.reserve(types.size());
     for (qsizetype i = 0; i < types.size(); ++i) {
-        const FieldValue &type = types.at(i);
-        if (type == FieldValue::Bit) {
+        const qmq::FieldValue &type = types.at(i);
+        if (type == qmq::FieldValue::Bit) {
             ++bitPos;
         }
-        if ((type != FieldValue::Bit) || (i == types.size() - 1)) {
+        if ((type != qmq::FieldValue::Bit) || (i == types.size() - 1)) {
             while (bitPos > 0) {
                 const quint8 byte = readAmqp<quint8>(io, &isOk);
                 const int numBitsRead = std::min(bitPos, 8);
@@ -712,8 +675,8 @@ QVariantList qmq::Frame::readNativeFieldValues(QIODevice *io,
                 bitPos -= numBitsRead;
             }
         }
-        if (type != FieldValue::Bit) {
-            ret.push_back(readNativeFieldValue(io, type, &isOk));
+        if (type != qmq::FieldValue::Bit) {
+            ret.push_back(readNativeFieldValueImpl(io, type, &isOk));
         }
     }
     if (ok != nullptr) {
@@ -722,60 +685,63 @@ QVariantList qmq::Frame::readNativeFieldValues(QIODevice *io,
     return ret;
 }
 
-bool qmq::Frame::writeFieldValue(QIODevice *io, const QVariant &value)
+template<typename Output>
+bool writeFieldValueImpl(Output *io, const QVariant &value)
 {
-    const FieldValue valueType = metatypeToFieldValue(value.typeId());
-    return writeFieldValue(io, value, valueType);
+    const qmq::FieldValue valueType = qmq::Frame::metatypeToFieldValue(value.typeId());
+    return writeFieldValueImpl(io, value, valueType);
 }
 
-bool qmq::Frame::writeFieldValue(QIODevice *io, const QVariant &value, FieldValue valueType)
+template<typename Output>
+bool writeFieldValueImpl(Output *io, const QVariant &value, qmq::FieldValue valueType)
 {
     const bool isOk = writeAmqp<quint8>(io, static_cast<quint8>(valueType));
     if (!isOk) {
         return false;
     }
 
-    return writeNativeFieldValue(io, value, valueType);
+    return writeNativeFieldValueImpl(io, value, valueType);
 }
 
-bool qmq::Frame::writeNativeFieldValue(QIODevice *io, const QVariant &value, FieldValue valueType)
+template<typename Output>
+bool writeNativeFieldValueImpl(Output *io, const QVariant &value, qmq::FieldValue valueType)
 {
     switch (valueType) {
-    case FieldValue::Boolean:
+    case qmq::FieldValue::Boolean:
         return writeAmqpBool(io, value.toBool());
-    case FieldValue::ShortShortInt:
+    case qmq::FieldValue::ShortShortInt:
         return writeAmqpVariant<qint8>(io, value);
-    case FieldValue::ShortShortUint:
+    case qmq::FieldValue::ShortShortUint:
         return writeAmqpVariant<quint8>(io, value);
-    case FieldValue::ShortInt:
+    case qmq::FieldValue::ShortInt:
         return writeAmqpVariant<qint16>(io, value);
-    case FieldValue::ShortUint:
+    case qmq::FieldValue::ShortUint:
         return writeAmqpVariant<quint16>(io, value);
-    case FieldValue::LongInt:
+    case qmq::FieldValue::LongInt:
         return writeAmqpVariant<qint32>(io, value);
-    case FieldValue::LongUint:
+    case qmq::FieldValue::LongUint:
         return writeAmqpVariant<quint32>(io, value);
-    case FieldValue::LongLongInt:
+    case qmq::FieldValue::LongLongInt:
         return writeAmqpVariant<qint64>(io, value);
-    case FieldValue::LongLongUint:
+    case qmq::FieldValue::LongLongUint:
         return writeAmqpVariant<quint64>(io, value);
-    case FieldValue::Float:
+    case qmq::FieldValue::Float:
         return writeAmqpVariant<float>(io, value);
-    case FieldValue::Double:
+    case qmq::FieldValue::Double:
         return writeAmqpVariant<double>(io, value);
-    case FieldValue::DecimalValue:
+    case qmq::FieldValue::DecimalValue:
         return writeAmqpVariantDecimal(io, value);
-    case FieldValue::ShortString:
+    case qmq::FieldValue::ShortString:
         return writeAmqpVariantShortString(io, value);
-    case FieldValue::LongString:
+    case qmq::FieldValue::LongString:
         return writeAmqpVariantLongString(io, value);
-    case FieldValue::FieldArray:
+    case qmq::FieldValue::FieldArray:
         return writeAmqpVariantFieldArray(io, value);
-    case FieldValue::Timestamp:
+    case qmq::FieldValue::Timestamp:
         return writeAmqpVariantTimestamp(io, value);
-    case FieldValue::FieldTable:
+    case qmq::FieldValue::FieldTable:
         return writeAmqpVariantFieldTable(io, value);
-    case FieldValue::Void:
+    case qmq::FieldValue::Void:
         return true;
         break;
     default:
@@ -784,22 +750,23 @@ bool qmq::Frame::writeNativeFieldValue(QIODevice *io, const QVariant &value, Fie
     }
 }
 
-bool qmq::Frame::writeNativeFieldValues(QIODevice *io,
-                                        const QVariantList &values,
-                                        const QList<FieldValue> &types)
+template<typename Output>
+bool writeNativeFieldValuesImpl(Output *io,
+                                const QVariantList &values,
+                                const QList<qmq::FieldValue> &types)
 {
     bool isOk = true;
     int bitPos = 0;
     quint8 bitBuffer = 0;
     for (qsizetype i = 0; i < types.size(); ++i) {
-        const FieldValue &type = types.at(i);
+        const qmq::FieldValue &type = types.at(i);
         const QVariant &value = values.at(i);
 #ifndef NDEBUG
         if (!verifyTypeCompat(type, value.metaType())) {
             qWarning() << "Incompatible type" << (char) type << value.metaType().name() << i;
         }
 #endif
-        if (type == FieldValue::Bit) {
+        if (type == qmq::FieldValue::Bit) {
             if (!value.canConvert<bool>()) {
                 qWarning() << "Failed conversion to bool";
                 return false;
@@ -811,7 +778,7 @@ bool qmq::Frame::writeNativeFieldValues(QIODevice *io,
             ++bitPos;
         }
         if ((bitPos == 8)
-            || (bitPos > 0 && ((type != FieldValue::Bit) || (i == types.size() - 1)))) {
+            || (bitPos > 0 && ((type != qmq::FieldValue::Bit) || (i == types.size() - 1)))) {
             isOk = writeAmqp<quint8>(io, bitBuffer);
             if (!isOk) {
                 return false;
@@ -819,8 +786,8 @@ bool qmq::Frame::writeNativeFieldValues(QIODevice *io,
             bitBuffer = 0;
             bitPos = 0;
         }
-        if (type != FieldValue::Bit) {
-            isOk = writeNativeFieldValue(io, value, type);
+        if (type != qmq::FieldValue::Bit) {
+            isOk = writeNativeFieldValueImpl(io, value, type);
         }
         if (!isOk) {
             return false;
@@ -829,6 +796,191 @@ bool qmq::Frame::writeNativeFieldValues(QIODevice *io,
     return isOk;
 }
 
+} // namespace
+
+qmq::FieldValue qmq::Frame::metatypeToFieldValue(int typeId)
+{
+    switch (typeId) {
+    case QMetaType::Type::Bool:
+        return qmq::FieldValue::Boolean;
+    case QMetaType::Type::Char:
+        return qmq::FieldValue::ShortShortInt;
+    case QMetaType::Type::UChar:
+        return qmq::FieldValue::ShortShortUint;
+    case QMetaType::Type::Short:
+        return qmq::FieldValue::ShortInt;
+    case QMetaType::Type::UShort:
+        return qmq::FieldValue::ShortUint;
+    case QMetaType::Type::Int:
+        return qmq::FieldValue::LongInt;
+    case QMetaType::Type::UInt:
+        return qmq::FieldValue::LongUint;
+    case QMetaType::Type::LongLong:
+        return qmq::FieldValue::LongLongInt;
+    case QMetaType::Type::ULongLong:
+        return qmq::FieldValue::LongLongUint;
+    case QMetaType::Type::Float:
+        return qmq::FieldValue::Float;
+    case QMetaType::Type::Double:
+        return qmq::FieldValue::Double;
+    // Decimal is handled later because the value isn't a compile-time constant
+    case QMetaType::Type::QString:
+        return qmq::FieldValue::ShortString;
+    case QMetaType::Type::QByteArray:
+        return qmq::FieldValue::LongString;
+    case QMetaType::Type::QVariantList:
+        return qmq::FieldValue::FieldArray;
+    case QMetaType::Type::QDateTime:
+        return qmq::FieldValue::Timestamp;
+    case QMetaType::Type::QVariantHash:
+        return qmq::FieldValue::FieldTable;
+    case QMetaType::Type::Void:
+        return qmq::FieldValue::Void;
+    default:
+        break;
+    }
+    if (typeId == qMetaTypeId<qmq::Decimal>()) {
+        return qmq::FieldValue::DecimalValue;
+    }
+    return qmq::FieldValue::Invalid;
+}
+
+QMetaType::Type qmq::Frame::fieldValueToMetatype(qmq::FieldValue fieldtype)
+{
+    switch (fieldtype) {
+    case qmq::FieldValue::Bit:
+        Q_FALLTHROUGH();
+    case qmq::FieldValue::Boolean:
+        return QMetaType::Type::Bool;
+    case qmq::FieldValue::ShortShortInt:
+        return QMetaType::Type::Char;
+    case qmq::FieldValue::ShortShortUint:
+        return QMetaType::Type::UChar;
+    case qmq::FieldValue::ShortInt:
+        return QMetaType::Type::Short;
+    case qmq::FieldValue::ShortUint:
+        return QMetaType::Type::UShort;
+    case qmq::FieldValue::LongInt:
+        return QMetaType::Type::Int;
+    case qmq::FieldValue::LongUint:
+        return QMetaType::Type::UInt;
+    case qmq::FieldValue::LongLongInt:
+        return QMetaType::Type::LongLong;
+    case qmq::FieldValue::LongLongUint:
+        return QMetaType::Type::ULongLong;
+    case qmq::FieldValue::Float:
+        return QMetaType::Type::Float;
+    case qmq::FieldValue::Double:
+        return QMetaType::Type::Double;
+    case qmq::FieldValue::DecimalValue:
+        return static_cast<QMetaType::Type>(qMetaTypeId<qmq::Decimal>());
+    case qmq::FieldValue::ShortString:
+        return QMetaType::Type::QString;
+    case qmq::FieldValue::LongString:
+        return QMetaType::Type::QByteArray;
+    case qmq::FieldValue::FieldArray:
+        return QMetaType::Type::QVariantList;
+    case qmq::FieldValue::Timestamp:
+        return QMetaType::Type::QDateTime;
+    case qmq::FieldValue::FieldTable:
+        return QMetaType::Type::QVariantHash;
+    case qmq::FieldValue::Void:
+        return QMetaType::Type::Void;
+    case qmq::FieldValue::Invalid:
+        return QMetaType::Type::UnknownType;
+    default:
+        qCritical() << "Bad Fieldtype" << (int) fieldtype;
+        return QMetaType::Type::UnknownType;
+    }
+}
+
+QVariant qmq::Frame::readFieldValue(QIODevice *io, bool *ok)
+{
+    return readFieldValueImpl(io, ok);
+}
+
+QVariant qmq::Frame::readNativeFieldValue(QIODevice *io, FieldValue type, bool *ok)
+{
+    return readNativeFieldValueImpl(io, type, ok);
+}
+
+QVariantList qmq::Frame::readNativeFieldValues(QIODevice *io,
+                                               const QList<FieldValue> &types,
+                                               bool *ok)
+{
+    return readNativeFieldValuesImpl(io, types, ok);
+}
+
+bool qmq::Frame::writeFieldValue(QIODevice *io, const QVariant &value)
+{
+    return writeFieldValueImpl(io, value);
+}
+
+bool qmq::Frame::writeFieldValue(QIODevice *io, const QVariant &value, FieldValue valueType)
+{
+    return writeFieldValueImpl(io, value, valueType);
+}
+
+bool qmq::Frame::writeNativeFieldValue(QIODevice *io, const QVariant &value, FieldValue valueType)
+{
+    return writeNativeFieldValueImpl(io, value, valueType);
+}
+
+bool qmq::Frame::writeNativeFieldValues(QIODevice *io,
+                                        const QVariantList &values,
+                                        const QList<FieldValue> &types)
+{
+    return writeNativeFieldValuesImpl(io, values, types);
+}
+
+QVariantHash qmq::detail::readTable(ByteCursor *in, bool *ok)
+{
+    bool isOk = true;
+    QVariantHash result = readAmqpVariantFieldTable(in, &isOk);
+    if (!isOk) {
+        *ok = false;
+    }
+    return result;
+}
+
+bool qmq::detail::writeTable(ByteWriter *out, const QVariantHash &value)
+{
+    return writeAmqpFieldTable(out, value);
+}
+
+namespace {
+std::unique_ptr<qmq::Frame> frameFromContent(qmq::FrameType t,
+                                             quint16 channel,
+                                             const qmq::ByteView &content,
+                                             qmq::ErrorCode *err)
+{
+    std::unique_ptr<qmq::Frame> frame;
+    switch (t) {
+    case qmq::FrameType::Method:
+        frame = qmq::MethodFrame::fromContent(channel, content);
+        break;
+    case qmq::FrameType::Header:
+        frame = qmq::HeaderFrame::fromContent(channel, content);
+        break;
+    case qmq::FrameType::Body:
+        frame = qmq::BodyFrame::fromContent(channel, content);
+        break;
+    case qmq::FrameType::Heartbeat:
+        frame = qmq::HeartbeatFrame::fromContent(channel, content);
+        break;
+    default:
+        *err = qmq::ErrorCode::UnknownFrameType;
+        qWarning() << "Unknown frame type";
+        return frame;
+    }
+    if (!frame) {
+        *err = qmq::ErrorCode::InvalidFrameData;
+        qWarning() << "Invalid frame content";
+    }
+    return frame;
+}
+} // namespace
+
 std::unique_ptr<qmq::Frame> qmq::Frame::readFrame(QIODevice *io,
                                                   quint32 maxFrameSize,
                                                   ErrorCode *err)
@@ -880,50 +1032,58 @@ std::unique_ptr<qmq::Frame> qmq::Frame::readFrame(QIODevice *io,
     }
     qDebug() << ":Frame::readFrame Construct frame from data. channel:" << channel
              << "content size:" << size;
-    switch (t) {
-    case qmq::FrameType::Method:
-        return std::unique_ptr<qmq::Frame>(MethodFrame::fromContent(channel, content).release());
-    case qmq::FrameType::Header:
-        return std::unique_ptr<qmq::Frame>(HeaderFrame::fromContent(channel, content).release());
-    case qmq::FrameType::Body:
-        return std::unique_ptr<qmq::Frame>(BodyFrame::fromContent(channel, content).release());
-    case qmq::FrameType::Heartbeat:
-        return std::unique_ptr<qmq::Frame>(HeartbeatFrame::fromContent(channel, content).release());
-    default:
-        *err = ErrorCode::UnknownFrameType;
-        qWarning() << "Unknown frame type";
-        return std::unique_ptr<qmq::Frame>();
-    }
+    return frameFromContent(t, channel, ByteView(content), err);
 }
 
-bool qmq::Frame::writeFrame(QIODevice *io, quint32 maxFrameSize, const Frame &f)
+std::unique_ptr<qmq::Frame> qmq::Frame::readFrame(const QByteArray &buffer,
+                                                  qsizetype *offset,
+                                                  quint32 maxFrameSize,
+                                                  ErrorCode *err)
 {
-    qDebug() << "Writing frame to channel" << f.channel() << "with type=" << (int) f.type();
-    const QByteArray content = f.content();
+    const qsizetype start = *offset;
+    const qsizetype available = buffer.size() - start;
+    if (available < (FrameHeaderSize + 1)) {
+        *err = ErrorCode::InsufficientDataAvailable;
+        return std::unique_ptr<qmq::Frame>();
+    }
 
-    const quint8 t = static_cast<quint8>(f.type());
-    const quint16 channel = f.channel();
-    const quint32 size = content.size();
+    const char *header = buffer.constData() + start;
+    const FrameType t = static_cast<FrameType>(header[0]);
+    const quint16 channel = qFromBigEndian<quint16>(header + 1);
+    const quint32 size = qFromBigEndian<quint32>(header + 3);
 
-    if (maxFrameSize != 0 && (content.size() + FrameHeaderSize + 1) > maxFrameSize) {
-        qWarning() << "Cannot write frame: too large.";
-        return false;
+    if (maxFrameSize != 0 && size > maxFrameSize) {
+        *err = ErrorCode::FrameTooLarge;
+        qWarning() << "Frame too large" << size;
+        return std::unique_ptr<qmq::Frame>();
+    }
+    if (available < (qsizetype(size) + FrameHeaderSize + 1)) {
+        *err = ErrorCode::InsufficientDataAvailable;
+        return std::unique_ptr<qmq::Frame>();
     }
 
-    // Create a temporary store so that the frame is written in a single TCP write operation.
-    QByteArray iobuffer;
-    iobuffer.reserve(size + 8);
-    QBuffer buf(&iobuffer);
-    buf.open(QIODevice::WriteOnly);
+    const quint8 endByte = static_cast<quint8>(header[FrameHeaderSize + size]);
+    if (endByte != FrameEndChar) {
+        *err = ErrorCode::InvalidFrameData;
+        qWarning() << "Frame end byte invalid" << (int) endByte;
+        return std::unique_ptr<qmq::Frame>();
+    }
 
-    bool isOk = writeAmqp<quint8>(&buf, t);
-    isOk = isOk && writeAmqp<quint16>(&buf, channel);
-    isOk = isOk && writeAmqp<quint32>(&buf, size);
-    isOk = isOk && (buf.write(content) == content.size());
-    isOk = isOk && writeAmqp<quint8>(&buf, FrameEndChar);
+    *offset = start + FrameHeaderSize + size + 1;
+    // The frame content refers to the buffer; nothing is copied here.
+    return frameFromContent(t, channel, ByteView(buffer, start + FrameHeaderSize, size), err);
+}
 
-    // Actually send the packet.
-    isOk = isOk && (io->write(iobuffer) == iobuffer.size());
+bool qmq::Frame::writeFrame(QIODevice *io, quint32 maxFrameSize, const Frame &f)
+{
+    qDebug() << "Writing frame to channel" << f.channel() << "with type=" << (int) f.type();
+    // Serialized into one buffer so that the frame is written in a single TCP write operation.
+    detail::FrameWriter writer(maxFrameSize);
+    if (!writer.writeFrame(f)) {
+        return false;
+    }
+    const qsizetype size = writer.size();
+    const bool isOk = writer.flush(io);
     qDebug() << "Written frame" << (isOk ? "OK" : "FAILED") << "with size" << size;
     return isOk;
 }
@@ -933,46 +1093,49 @@ std::unique_ptr<qmq::BodyFrame> qmq::BodyFrame::fromContent(quint16 channel,
 {
     return std::make_unique<qmq::BodyFrame>(channel, content);
 }
+
+std::unique_ptr<qmq::BodyFrame> qmq::BodyFrame::fromContent(quint16 channel,
+                                                            const ByteView &content)
+{
+    return std::make_unique<qmq::BodyFrame>(channel, content);
+}
+
 std::unique_ptr<qmq::MethodFrame> qmq::MethodFrame::fromContent(quint16 channel,
                                                                 const QByteArray &content)
 {
-    QBuffer io;
-    io.setData(content);
-    bool isOk = io.open(QIODevice::ReadOnly);
+    return fromContent(channel, ByteView(content));
+}
+
+std::unique_ptr<qmq::MethodFrame> qmq::MethodFrame::fromContent(quint16 channel,
+                                                                const ByteView &content)
+{
+    detail::ByteCursor io(content);
+    bool isOk = false;
+    if (io.bytesAvailable() < 4) {
+        qWarning() << "Method frame too short" << content.size();
+        return std::unique_ptr<qmq::MethodFrame>();
+    }
     const quint16 classId = readAmqp<quint16>(&io, &isOk);
     const quint16 methodId = readAmqp<quint16>(&io, &isOk);
-    const QByteArray arguments = content.mid(4);
-    return std::make_unique<qmq::MethodFrame>(channel, classId, methodId, arguments);
+    return std::make_unique<qmq::MethodFrame>(channel, classId, methodId, content.mid(4));
 }
 
 QByteArray qmq::MethodFrame::content() const
 {
-    qDebug() << "Get method content";
-    QBuffer io;
-    bool isOk = io.open(QIODevice::WriteOnly);
-    isOk = isOk && writeAmqp<quint16>(&io, this->classId());
-    isOk = isOk && writeAmqp<quint16>(&io, this->methodId());
-    isOk = isOk && (io.write(this->m_arguments) == this->m_arguments.size());
-    if (!isOk) {
-        qWarning() << "Failed writing frame content";
-    }
-    io.close();
-    return io.data();
+    QByteArray result;
+    result.reserve(4 + m_arguments.size());
+    detail::ByteWriter io(&result);
+    detail::writeValue<quint16>(&io, this->classId());
+    detail::writeValue<quint16>(&io, this->methodId());
+    io.write(m_arguments.data(), m_arguments.size());
+    return result;
 }
 
 QVariantList qmq::MethodFrame::getArguments(bool *ok) const
 {
     const QList<FieldValue> types = spec::methodArgs(this->classId(), this->methodId());
-    QBuffer io;
-    io.setData(this->m_arguments);
-    bool isOk = io.open(QIODevice::ReadOnly);
-    if (!isOk) {
-        if (ok != nullptr)
-            *ok = false;
-        qWarning() << "Unable to open stream for reading";
-        return QVariantList();
-    }
-    return Frame::readNativeFieldValues(&io, types, ok);
+    detail::ByteCursor io(m_arguments);
+    return readNativeFieldValuesImpl(&io, types, ok);
 }
 
 bool qmq::MethodFrame::setArguments(const QVariantList &values)
@@ -989,43 +1152,50 @@ bool qmq::MethodFrame::setArguments(const QVariantList &values)
     }
     isOk = Frame::writeNativeFieldValues(&io, values, types);
     io.close();
-    this->m_arguments = io.buffer();
+    this->m_arguments = ByteView(io.buffer());
     return isOk;
 }
 
 qmq::HeaderFrame::HeaderFrame(quint16 channel,
                               quint16 classId,
                               quint64 contentSize,
-                              const QHash<qmq::BasicProperty, QVariant> &properties)
+                              const BasicProperties &properties)
     : Frame(qmq::FrameType::Header, channel)
     , m_classId(classId)
     , m_contentSize(contentSize)
     , m_properties(properties)
 {}
 
+qmq::HeaderFrame::HeaderFrame(quint16 channel,
+                              quint16 classId,
+                              quint64 contentSize,
+                              const QHash<qmq::BasicProperty, QVariant> &properties)
+    : HeaderFrame(channel, classId, contentSize, BasicProperties::fromHash(properties))
+{}
+
 std::unique_ptr<qmq::HeaderFrame> qmq::HeaderFrame::fromContent(quint16 channel,
                                                                 const QByteArray &content)
 {
-    QBuffer io;
-    io.setData(content);
-    bool isOk = io.open(QIODevice::ReadOnly);
+    return fromContent(channel, ByteView(content));
+}
+
+std::unique_ptr<qmq::HeaderFrame> qmq::HeaderFrame::fromContent(quint16 channel,
+                                                                const ByteView &content)
+{
+    detail::ByteCursor io(content);
+    if (io.bytesAvailable() < 14) {
+        qWarning() << "Header frame too short" << content.size();
+        return std::unique_ptr<qmq::HeaderFrame>();
+    }
+    bool isOk = true;
     const quint16 classId = readAmqp<quint16>(&io, &isOk);
     /* const quint16 weight = */ readAmqp<quint16>(&io, &isOk);
     const quint64 contentSize = readAmqp<quint64>(&io, &isOk);
-    const quint16 propertyFlags = readAmqp<quint16>(&io, &isOk);
-    if (!isOk) {
-        qWarning() << "Buffer not opened";
-        return std::unique_ptr<qmq::HeaderFrame>();
-    }
 
-    QHash<BasicProperty, QVariant> properties;
-    for (unsigned int i = 0; i < std::size(spec::basicPropertyTypes); ++i) {
-        if ((propertyFlags & ((1 << 15) >> i)) != 0) {
-            const FieldValue propType = spec::basicPropertyTypes[i];
-            const QVariant value = Frame::readNativeFieldValue(&io, propType, &isOk);
-            const BasicProperty propId = static_cast<BasicProperty>(i);
-            properties.insert(propId, value);
-        }
+    BasicProperties properties;
+    if (!detail::readBasicProperties(&io, &properties)) {
+        qWarning() << "Failed to read header properties";
+        return std::unique_ptr<qmq::HeaderFrame>();
     }
 
     return std::make_unique<qmq::HeaderFrame>(channel, classId, contentSize, properties);
@@ -1033,52 +1203,26 @@ std::unique_ptr<qmq::HeaderFrame> qmq::HeaderFrame::fromContent(quint16 channel,
 
 QByteArray qmq::HeaderFrame::content() const
 {
-    QList<BasicProperty> proplist(m_properties.keys());
-    std::sort(proplist.begin(), proplist.end());
-
-    quint16 propertyFlags = 0;
-    QVariantList orderedValues;
-    QList<FieldValue> orderedTypes;
-    orderedValues.reserve(m_properties.size());
-    orderedTypes.reserve(m_properties.size());
-
-    for (BasicProperty it : proplist) {
-        const int itIndex = (int) it;
-        propertyFlags |= ((1 << 15) >> itIndex); // High bit comes first.
-        orderedValues.push_back(m_properties.value(it));
-        orderedTypes.push_back(spec::basicPropertyTypes[itIndex]);
-    }
-    QBuffer io;
-    bool isOk = io.open(QIODevice::WriteOnly);
-    if (!isOk) {
-        qWarning() << "Buffer not opened";
-        return QByteArray();
-    }
-    do {
-        isOk = writeAmqp<quint16>(&io, this->classId());
-        if (!isOk)
-            break;
-        isOk = writeAmqp<quint16>(&io, 0); // weight.
-        if (!isOk)
-            break;
-        isOk = writeAmqp<quint64>(&io, this->contentSize());
-        if (!isOk)
-            break;
-        isOk = writeAmqp<quint16>(&io, propertyFlags);
-        if (!isOk)
-            break;
-        isOk = Frame::writeNativeFieldValues(&io, orderedValues, orderedTypes);
-    } while (false);
-    io.close();
-    if (!isOk) {
+    QByteArray result;
+    detail::ByteWriter io(&result);
+    detail::writeValue<quint16>(&io, this->classId());
+    detail::writeValue<quint16>(&io, 0); // weight.
+    detail::writeValue<quint64>(&io, this->contentSize());
+    if (!detail::writeBasicProperties(&io, m_properties)) {
         qWarning() << "Error writing field values";
         return QByteArray();
     }
-    return io.buffer();
+    return result;
 }
 
 std::unique_ptr<qmq::HeartbeatFrame> qmq::HeartbeatFrame::fromContent(quint16 channel,
                                                                       const QByteArray &content)
+{
+    return fromContent(channel, ByteView(content));
+}
+
+std::unique_ptr<qmq::HeartbeatFrame> qmq::HeartbeatFrame::fromContent(quint16 channel,
+                                                                      const ByteView &content)
 {
     if (channel != 0) {
         qWarning() << "Hearbeat frame non-zero channel";
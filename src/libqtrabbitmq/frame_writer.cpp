@@ -0,0 +1,162 @@
+#include "frame_writer.h"
+#include "spec_constants.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace qmq::detail {
+
+namespace {
+constexpr const qsizetype frameHeaderSize = 7;
+constexpr const qsizetype frameOverhead = frameHeaderSize + 1;
+} // namespace
+
+qsizetype FrameWriter::beginFrame(FrameType type, quint16 channel)
+{
+    const qsizetype start = m_buffer.size();
+    writeValue<quint8>(&m_out, static_cast<quint8>(type));
+    writeValue<quint16>(&m_out, channel);
+    writeValue<quint32>(&m_out, 0); // Size, patched by endFrame().
+    return start;
+}
+
+bool FrameWriter::endFrame(qsizetype start, bool contentOk)
+{
+    const qsizetype size = m_buffer.size() - start - frameHeaderSize;
+    if (!contentOk) {
+        qWarning() << "Failed writing frame content";
+        m_buffer.truncate(start);
+        return false;
+    }
+    if (m_maxFrameSize != 0 && size + frameOverhead > qsizetype(m_maxFrameSize)) {
+        qWarning() << "Cannot write frame: too large." << size;
+        m_buffer.truncate(start);
+        return false;
+    }
+    qToBigEndian<quint32>(static_cast<quint32>(size), m_buffer.data() + start + 3);
+    writeValue<quint8>(&m_out, static_cast<quint8>(spec::constants::FrameEnd));
+    return true;
+}
+
+bool FrameWriter::writeFrame(const Frame &frame)
+{
+    switch (frame.type()) {
+    case FrameType::Method: {
+        const auto &method = static_cast<const MethodFrame &>(frame);
+        return writeMethod(method.channel(),
+                           method.classId(),
+                           method.methodId(),
+                           method.argumentsView());
+    }
+    case FrameType::Header: {
+        const auto &header = static_cast<const HeaderFrame &>(frame);
+        return writeHeader(header.channel(),
+                           header.classId(),
+                           header.contentSize(),
+                           header.basicProperties());
+    }
+    case FrameType::Body: {
+        const ByteView &body = static_cast<const BodyFrame &>(frame).bodyView();
+        return writeBody(frame.channel(), body.data(), body.size());
+    }
+    case FrameType::Heartbeat:
+        return writeHeartbeat();
+    default:
+        break;
+    }
+    // Unknown frame types still know how to produce their content.
+    const qsizetype start = beginFrame(frame.type(), frame.channel());
+    m_out.write(frame.content());
+    return endFrame(start, true);
+}
+
+bool FrameWriter::writeMethod(quint16 channel,
+                              quint16 classId,
+                              quint16 methodId,
+                              const ByteView &args)
+{
+    const qsizetype start = beginFrame(FrameType::Method, channel);
+    writeValue<quint16>(&m_out, classId);
+    writeValue<quint16>(&m_out, methodId);
+    m_out.write(args.data(), args.size());
+    return endFrame(start, true);
+}
+
+bool FrameWriter::writeHeader(quint16 channel,
+                              quint16 classId,
+                              quint64 contentSize,
+                              const BasicProperties &properties)
+{
+    const qsizetype start = beginFrame(FrameType::Header, channel);
+    writeValue<quint16>(&m_out, classId);
+    writeValue<quint16>(&m_out, 0); // weight.
+    writeValue<quint64>(&m_out, contentSize);
+    return endFrame(start, writeBasicProperties(&m_out, properties));
+}
+
+bool FrameWriter::writeBody(quint16 channel, const char *data, qsizetype size)
+{
+    const qsizetype start = beginFrame(FrameType::Body, channel);
+    m_out.write(data, size);
+    return endFrame(start, true);
+}
+
+bool FrameWriter::writeHeartbeat()
+{
+    return endFrame(beginFrame(FrameType::Heartbeat, 0), true);
+}
+
+bool FrameWriter::writeContent(quint16 channel,
+                               quint16 classId,
+                               const BasicProperties &properties,
+                               QByteArrayView payload)
+{
+    const qsizetype start = m_buffer.size();
+    if (!writeHeader(channel, classId, quint64(payload.size()), properties)) {
+        return false;
+    }
+    if (!writeBodies(channel, payload)) {
+        m_buffer.truncate(start);
+        return false;
+    }
+    return true;
+}
+
+bool FrameWriter::writeBodies(quint16 channel, QByteArrayView payload)
+{
+    const qsizetype start = m_buffer.size();
+    const qsizetype maxPayloadSize = (m_maxFrameSize == 0) ? payload.size()
+                                                           : qsizetype(m_maxFrameSize)
+                                                                 - frameOverhead;
+    if (maxPayloadSize <= 0 && !payload.isEmpty()) {
+        qWarning() << "Maximum frame size too small for content" << m_maxFrameSize;
+        return false;
+    }
+    const qsizetype bodyFrames = payload.isEmpty() ? 0 : (payload.size() - 1) / maxPayloadSize + 1;
+    m_buffer.reserve(start + payload.size() + bodyFrames * frameOverhead);
+
+    for (qsizetype written = 0; written < payload.size();) {
+        const qsizetype len = std::min(maxPayloadSize, payload.size() - written);
+        if (!writeBody(channel, payload.constData() + written, len)) {
+            m_buffer.truncate(start);
+            return false;
+        }
+        written += len;
+    }
+    return true;
+}
+
+bool FrameWriter::flush(QIODevice *io)
+{
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+    const bool isOk = (io->write(m_buffer) == m_buffer.size());
+    // Keeps the allocation for the next frames, unless the device still shares it.
+    m_buffer.resize(0);
+    return isOk;
+}
+
+} // namespace qmq::detail
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "amqp_codec.h"
+#include "byte_writer.h"
+
+#include <qtrabbitmq/basic_properties.h>
+#include <qtrabbitmq/frame.h>
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QIODevice>
+
+namespace qmq::detail {
+
+//! Serializes frames in a single pass into one reusable output buffer.
+//!
+//! Each frame header is reserved up front and its size field backpatched once the content
+//! has been written, so that method arguments, content headers and body payloads are copied
+//! exactly once, straight into the buffer that is handed to the socket by flush().
+//!
+//! A frame that fails to encode, or would exceed the maximum frame size, is rolled back and
+//! leaves the buffer as it was.
+class FrameWriter
+{
+public:
+    explicit FrameWriter(quint32 maxFrameSize = 0)
+        : m_out(&m_buffer)
+        , m_maxFrameSize(maxFrameSize)
+    {}
+    FrameWriter(const FrameWriter &) = delete;
+    FrameWriter &operator=(const FrameWriter &) = delete;
+
+    //! maxFrameSize of 0 is treated as unlimited.
+    quint32 maxFrameSize() const { return m_maxFrameSize; }
+    void setMaxFrameSize(quint32 n) { m_maxFrameSize = n; }
+
+    bool writeFrame(const Frame &frame);
+
+    //! Writes a method frame, encoding the generated method struct in place.
+    template<typename Method>
+    bool writeMethod(quint16 channel, const Method &method)
+    {
+        const qsizetype start = beginFrame(FrameType::Method, channel);
+        writeValue<quint16>(&m_out, Method::ClassId);
+        writeValue<quint16>(&m_out, Method::MethodId);
+        return endFrame(start, method.encode(&m_out));
+    }
+    bool writeMethod(quint16 channel, quint16 classId, quint16 methodId, const ByteView &args);
+    bool writeHeader(quint16 channel,
+                     quint16 classId,
+                     quint64 contentSize,
+                     const BasicProperties &properties);
+    //! Content header whose property flags and properties are written by \a writeProperties,
+    //! a callable taking the ByteWriter and returning false on failure.
+    template<typename Fn>
+    bool writeHeader(quint16 channel, quint16 classId, quint64 contentSize, Fn writeProperties)
+    {
+        const qsizetype start = beginFrame(FrameType::Header, channel);
+        writeValue<quint16>(&m_out, classId);
+        writeValue<quint16>(&m_out, 0); // weight.
+        writeValue<quint64>(&m_out, contentSize);
+        return endFrame(start, writeProperties(&m_out));
+    }
+    bool writeBody(quint16 channel, const char *data, qsizetype size);
+    //! Body frames for \a payload, split at the maximum frame size.
+    bool writeBodies(quint16 channel, QByteArrayView payload);
+    bool writeHeartbeat();
+
+    //! Content header followed by as many body frames as the maximum frame size requires.
+    //! The body frames are cut from \a payload directly; no intermediate slices are made.
+    bool writeContent(quint16 channel,
+                      quint16 classId,
+                      const BasicProperties &properties,
+                      QByteArrayView payload);
+
+    //! Appends frames that were serialized earlier, e.g. by a PublishTemplate.
+    void writeEncoded(QByteArrayView frames) { m_out.write(frames.data(), frames.size()); }
+
+    bool isEmpty() const { return m_buffer.isEmpty(); }
+    qsizetype size() const { return m_buffer.size(); }
+    const QByteArray &buffer() const { return m_buffer; }
+
+    //! Writes the buffered frames to \a io in one call and empties the buffer.
+    bool flush(QIODevice *io);
+    //! Drops buffered frames, e.g. after the connection was lost.
+    void clear() { m_buffer.resize(0); }
+    //! Drops frames written after size() returned \a mark, so that a group of frames that must
+    //! go out together (method, header and body) is never left half written.
+    void rollback(qsizetype mark) { m_buffer.truncate(mark); }
+
+private:
+    qsizetype beginFrame(FrameType type, quint16 channel);
+    bool endFrame(qsizetype start, bool contentOk);
+
+    QByteArray m_buffer;
+    ByteWriter m_out;
+    quint32 m_maxFrameSize = 0;
+};
+
+} // namespace qmq::detail
@@ -18,5 +18,6 @@ bool operator==(const qmq::Message &lhs, const qmq::Message &rhs)
 {
     return (lhs.deliveryTag() == rhs.deliveryTag()) && (lhs.exchangeName() == rhs.exchangeName())
            && (lhs.isRedelivered() == rhs.isRedelivered()) && (lhs.payload() == rhs.payload())
-           && (lhs.properties() == rhs.properties()) && (lhs.routingKey() == rhs.routingKey());
+           && (lhs.basicProperties() == rhs.basicProperties())
+           && (lhs.routingKey() == rhs.routingKey());
 }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace qmq::detail {
+
+//! Bounded queue for any number of producer threads and one consumer thread.
+//!
+//! Each cell carries a sequence number that tells producers and the consumer whose turn it is
+//! (D. Vyukov's bounded queue). Producers claim a cell with a compare-and-swap on the tail and
+//! never block each other on a lock; a full queue makes tryPush() fail rather than wait.
+template<typename T>
+class MpscQueue
+{
+public:
+    //! \a capacity is rounded up to a power of two.
+    explicit MpscQueue(size_t capacity)
+        : m_capacity(roundUp(capacity))
+        , m_mask(m_capacity - 1)
+        , m_cells(new Cell[m_capacity])
+    {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+    //! Any thread. Leaves \a value untouched and returns false when the queue is full.
+    bool tryPush(T &&value)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = m_cells[pos & m_mask];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! Consumer thread only.
+    bool tryPop(T *value)
+    {
+        const size_t pos = m_head;
+        Cell &cell = m_cells[pos & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        *value = std::move(cell.value);
+        cell.value = T();
+        cell.sequence.store(pos + m_capacity, std::memory_order_release);
+        m_head = pos + 1;
+        return true;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    static size_t roundUp(size_t n)
+    {
+        size_t c = 2;
+        while (c < n) {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) size_t m_head = 0;
+};
+
+} // namespace qmq::detail
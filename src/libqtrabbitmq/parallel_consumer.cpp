@@ -0,0 +1,256 @@
+#include "spsc_ring.h"
+#include <qtrabbitmq/ack_batcher.h>
+#include <qtrabbitmq/channel.h>
+#include <qtrabbitmq/consumer.h>
+#include <qtrabbitmq/parallel_consumer.h>
+
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr size_t RING_CAPACITY = 1024;
+
+struct Completion
+{
+    quint64 deliveryTag = 0;
+    bool isOk = false;
+};
+} // namespace
+
+namespace qmq {
+
+class ParallelConsumer::Private
+{
+public:
+    class Worker : public QThread
+    {
+    public:
+        explicit Worker(ParallelConsumer::Private *_owner)
+            : owner(_owner)
+            , jobs(RING_CAPACITY)
+            , done(RING_CAPACITY)
+        {}
+
+        //! Owner thread: wakes the worker if it is waiting for jobs.
+        void wake()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed) || stopping.load()) {
+                QMutexLocker locker(&mutex);
+                condition.wakeOne();
+            }
+        }
+
+        void stop()
+        {
+            stopping.store(true);
+            wake();
+            wait();
+        }
+
+        ParallelConsumer::Private *const owner;
+        detail::SpscRing<Message> jobs;
+        detail::SpscRing<Completion> done;
+        // Owner thread only: jobs that did not fit into the ring.
+        QQueue<Message> backlog;
+
+    protected:
+        void run() override
+        {
+            Message message;
+            while (!stopping.load()) {
+                if (jobs.tryPop(&message)) {
+                    const bool isOk = owner->handler && owner->handler(message);
+                    Completion completion{message.deliveryTag(), isOk};
+                    while (!done.tryPush(std::move(completion))) {
+                        owner->postDrain();
+                        QThread::yieldCurrentThread();
+                    }
+                    owner->postDrain();
+                    continue;
+                }
+                QMutexLocker locker(&mutex);
+                sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (jobs.isEmpty() && !stopping.load()) {
+                    condition.wait(&mutex);
+                }
+                sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        QMutex mutex;
+        QWaitCondition condition;
+        std::atomic<bool> sleeping{false};
+        std::atomic<bool> stopping{false};
+    };
+
+    QByteArray partitionKey(const MessageView &view) const
+    {
+        if (keyFunction) {
+            return keyFunction(view);
+        }
+        if (!headerName.isEmpty()) {
+            return view.basicProperties().headers().value(headerName).toByteArray();
+        }
+        return view.routingKey().toUtf8();
+    }
+
+    //! Owner thread: hands \a message to \a worker, keeping it back if the ring is full.
+    void dispatch(Worker *worker, Message &&message)
+    {
+        ++inFlight;
+        if (!worker->backlog.isEmpty() || !worker->jobs.tryPush(std::move(message))) {
+            worker->backlog.enqueue(std::move(message));
+            return;
+        }
+        worker->wake();
+    }
+
+    //! Worker threads: asks the owner thread to collect results, once per batch of them.
+    void postDrain()
+    {
+        if (!drainPosted.exchange(true)) {
+            QMetaObject::invokeMethod(
+                q, [this]() { drainCompletions(); }, Qt::QueuedConnection);
+        }
+    }
+
+    //! Owner thread: settles finished deliveries and refills the rings from the backlogs.
+    void drainCompletions()
+    {
+        // Pairs with the exchange in postDrain(), so results pushed before it are seen below.
+        drainPosted.exchange(false);
+        AckBatcher *batcher = channel ? channel->ackBatcher() : nullptr;
+        Completion completion;
+        for (const std::unique_ptr<Worker> &worker : workers) {
+            while (worker->done.tryPop(&completion)) {
+                --inFlight;
+                if (!batcher) {
+                    continue;
+                }
+                if (completion.isOk) {
+                    batcher->complete(completion.deliveryTag);
+                } else {
+                    batcher->reject(completion.deliveryTag, requeueOnFailure);
+                }
+            }
+            bool isRefilled = false;
+            while (!worker->backlog.isEmpty()
+                   && worker->jobs.tryPush(std::move(worker->backlog.head()))) {
+                worker->backlog.dequeue();
+                isRefilled = true;
+            }
+            if (isRefilled) {
+                worker->wake();
+            }
+        }
+    }
+
+    ParallelConsumer *q = nullptr;
+    int workerCount = 1;
+    Consumer *consumer = nullptr;
+    QPointer<Channel> channel;
+    WorkHandler handler;
+    PartitionKeyFunction keyFunction;
+    QString headerName;
+    bool requeueOnFailure = false;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> drainPosted{false};
+    int inFlight = 0;
+};
+
+ParallelConsumer::ParallelConsumer(int workerCount, const QString &consumerTag, QObject *parent)
+    : QObject(parent)
+    , d(new Private)
+{
+    d->q = this;
+    d->workerCount = qMax(workerCount, 1);
+    d->consumer = new Consumer(consumerTag, this);
+}
+
+ParallelConsumer::~ParallelConsumer()
+{
+    for (const std::unique_ptr<Private::Worker> &worker : d->workers) {
+        worker->stop();
+    }
+}
+
+QString ParallelConsumer::consumerTag() const
+{
+    return d->consumer->consumerTag();
+}
+
+int ParallelConsumer::workerCount() const
+{
+    return d->workerCount;
+}
+
+void ParallelConsumer::setWorkHandler(WorkHandler handler)
+{
+    d->handler = std::move(handler);
+}
+
+void ParallelConsumer::setPartitionByRoutingKey()
+{
+    d->keyFunction = {};
+    d->headerName.clear();
+}
+
+void ParallelConsumer::setPartitionByHeader(const QString &name)
+{
+    d->keyFunction = {};
+    d->headerName = name;
+}
+
+void ParallelConsumer::setPartitionKeyFunction(PartitionKeyFunction fn)
+{
+    d->keyFunction = std::move(fn);
+    d->headerName.clear();
+}
+
+bool ParallelConsumer::requeueOnFailure() const
+{
+    return d->requeueOnFailure;
+}
+
+void ParallelConsumer::setRequeueOnFailure(bool requeue)
+{
+    d->requeueOnFailure = requeue;
+}
+
+QFuture<QString> ParallelConsumer::consume(Channel *channel, const QString &queue)
+{
+    if (!d->handler) {
+        qWarning() << "ParallelConsumer has no work handler";
+    }
+    if (d->workers.empty()) {
+        for (int i = 0; i < d->workerCount; ++i) {
+            d->workers.push_back(std::make_unique<Private::Worker>(d.get()));
+            d->workers.back()->start();
+        }
+    }
+    d->channel = channel;
+    d->consumer->setHandler([this](const MessageView &view) {
+        const size_t index = size_t(qHash(d->partitionKey(view)) % d->workers.size());
+        d->dispatch(d->workers[index].get(), view.toMessage());
+    });
+    return d->consumer->consume(channel, queue);
+}
+
+int ParallelConsumer::inFlightCount() const
+{
+    return d->inFlight;
+}
+
+} // namespace qmq
@@ -0,0 +1,102 @@
+#include "amqp_codec.h"
+#include "frame_writer.h"
+#include "spec_constants.h"
+#include <qtrabbitmq/publish_template.h>
+
+#include <QDebug>
+
+namespace qmq {
+
+namespace {
+constexpr const quint16 messageIdFlag = BasicProperties::flag(BasicProperty::MessageId);
+constexpr const quint16 timestampFlag = BasicProperties::flag(BasicProperty::Timestamp);
+
+//! Encodes the properties of \a props selected by \a mask, without the flags word.
+bool encodeProperties(const BasicProperties &props, quint16 mask, QByteArray *encoded)
+{
+    BasicProperties selected = props;
+    for (int i = 0; i <= static_cast<int>(BasicProperty::_ClusterId); ++i) {
+        const BasicProperty p = static_cast<BasicProperty>(i);
+        if ((BasicProperties::flag(p) & mask) == 0) {
+            selected.remove(p);
+        }
+    }
+    QByteArray buffer;
+    detail::ByteWriter out(&buffer);
+    if (!detail::writeBasicProperties(&out, selected)) {
+        return false;
+    }
+    *encoded = buffer.mid(sizeof(quint16));
+    return true;
+}
+} // namespace
+
+PublishTemplate::PublishTemplate(quint16 channelId,
+                                 const QByteArray &methodFrame,
+                                 const QString &exchangeName,
+                                 const QString &routingKey,
+                                 const BasicProperties &properties)
+    : m_channelId(channelId)
+    , m_methodFrame(methodFrame)
+    , m_exchangeName(exchangeName)
+    , m_routingKey(routingKey)
+    , m_properties(properties)
+{
+    // Properties are written in flag order, most significant first: everything above MessageId
+    // leads, everything below Timestamp trails.
+    const quint16 leadingMask = static_cast<quint16>(~(messageIdFlag | (messageIdFlag - 1)));
+    const quint16 trailingMask = static_cast<quint16>(timestampFlag - 1);
+    if (!encodeProperties(properties, leadingMask, &m_leadingProperties)
+        || !encodeProperties(properties, trailingMask, &m_trailingProperties)) {
+        qWarning() << "Cannot encode publish template properties" << properties;
+        m_methodFrame.clear();
+    }
+}
+
+bool PublishTemplate::write(detail::FrameWriter *writer,
+                            QByteArrayView payload,
+                            const QString &messageId,
+                            const QDateTime &timestamp) const
+{
+    const qsizetype mark = writer->size();
+    writer->writeEncoded(m_methodFrame);
+    const auto properties = [&](detail::ByteWriter *out) {
+        return writeProperties(out, messageId, timestamp);
+    };
+    if (!writer->writeHeader(m_channelId, spec::basic::ID_, quint64(payload.size()), properties)
+        || !writer->writeBodies(m_channelId, payload)) {
+        writer->rollback(mark);
+        return false;
+    }
+    return true;
+}
+
+bool PublishTemplate::writeProperties(detail::ByteWriter *out,
+                                      const QString &messageId,
+                                      const QDateTime &timestamp) const
+{
+    quint16 flags = m_properties.flags();
+    if (!messageId.isEmpty()) {
+        flags |= messageIdFlag;
+    }
+    if (timestamp.isValid()) {
+        flags |= timestampFlag;
+    }
+    detail::writeValue<quint16>(out, flags);
+    out->write(m_leadingProperties);
+    if (flags & messageIdFlag) {
+        if (!detail::writeShortStr(out,
+                                   messageId.isEmpty() ? m_properties.messageId() : messageId)) {
+            return false;
+        }
+    }
+    if (flags & timestampFlag) {
+        detail::writeValue<qint64>(out,
+                                   timestamp.isValid() ? timestamp.toSecsSinceEpoch()
+                                                       : m_properties.timestampSecs());
+    }
+    out->write(m_trailingProperties);
+    return true;
+}
+
+} // namespace qmq
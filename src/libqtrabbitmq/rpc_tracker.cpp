@@ -0,0 +1,70 @@
+#include "rpc_tracker.h"
+
+#include <qtrabbitmq/exception.h>
+
+#include <QDebug>
+
+namespace qmq::detail {
+
+void RpcTracker::add(const ItemPtr &item, qint64 timeoutMs)
+{
+    m_queues[key(item->classId, item->methodId)].push_back(item);
+    ++m_count;
+    if (m_timers && timeoutMs > 0) {
+        const QWeakPointer<MessageItem> weak = item;
+        item->timeout = m_timers->start(timeoutMs, [weak]() {
+            const ItemPtr expired = weak.toStrongRef();
+            if (expired && !expired->isFinished()) {
+                qWarning() << "Request timed out: classID" << expired->classId
+                           << expired->methodId;
+                expired->timeout = 0;
+                expired->setException(qmq::Exception(408, "Request timed out"));
+                expired->finish();
+            }
+        });
+    }
+}
+
+RpcTracker::ItemPtr RpcTracker::take(quint16 classId, quint16 methodId)
+{
+    const auto it = m_queues.find(key(classId, methodId));
+    if (it == m_queues.end() || it->empty()) {
+        qWarning() << "No message found for classID" << classId << methodId;
+        return {};
+    }
+    ItemPtr item = it->front();
+    it->pop_front();
+    --m_count;
+    if (item->isFinished()) {
+        // Timed out already; the late reply has nobody to go to.
+        qDebug() << "Late reply for classID" << classId << methodId;
+        return {};
+    }
+    cancelTimeout(item.get());
+    return item;
+}
+
+void RpcTracker::failAll(const QException &exc)
+{
+    for (auto it = m_queues.begin(); it != m_queues.end(); ++it) {
+        for (const ItemPtr &item : *it) {
+            cancelTimeout(item.get());
+            if (!item->isFinished()) {
+                item->setException(exc);
+                item->finish();
+            }
+        }
+    }
+    m_queues.clear();
+    m_count = 0;
+}
+
+void RpcTracker::cancelTimeout(MessageItem *item)
+{
+    if (m_timers && item->timeout != 0) {
+        m_timers->cancel(item->timeout);
+        item->timeout = 0;
+    }
+}
+
+} // namespace qmq::detail
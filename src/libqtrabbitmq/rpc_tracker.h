@@ -0,0 +1,93 @@
+#pragma once
+
+#include "timer_wheel.h"
+
+#include <QException>
+#include <QHash>
+#include <QPromise>
+#include <QSharedPointer>
+#include <qglobal.h>
+
+#include <deque>
+
+namespace qmq::detail {
+
+//! A request waiting for its reply; the reply's type is fixed by the request method.
+class MessageItem
+{
+public:
+    MessageItem(quint16 cid, quint16 mid)
+        : classId(cid)
+        , methodId(mid)
+    {}
+    virtual ~MessageItem() = default;
+
+    virtual void start() = 0;
+    virtual void finish() = 0;
+    virtual void setException(const QException &) = 0;
+    virtual bool isFinished() const = 0;
+    quint16 classId = 0;
+    quint16 methodId = 0;
+    TimerWheel::TimerId timeout = 0;
+};
+
+template<class T>
+class MessagePromise : public MessageItem
+{
+public:
+    MessagePromise(quint16 cid, quint16 mid)
+        : MessageItem(cid, mid)
+    {}
+    void start() override { promise.start(); };
+    void finish() override { promise.finish(); };
+    void setException(const QException &exc) override { promise.setException(exc); }
+    bool isFinished() const override { return promise.future().isFinished(); }
+
+    QPromise<T> promise;
+};
+
+//! The requests of one channel that wait for a reply.
+//!
+//! The broker answers the requests of a channel in order, so each request method has its own
+//! FIFO and a reply takes the front of its method's queue in O(1). A request that timed out
+//! stays in its queue until its late reply arrives, so later replies still match up.
+//!
+//! Timeouts live in the client's timer wheel; a reply cancels its request's timeout in O(1).
+class RpcTracker
+{
+public:
+    using ItemPtr = QSharedPointer<MessageItem>;
+
+    //! Without a wheel, requests never time out.
+    void setTimerWheel(TimerWheel *timers) { m_timers = timers; }
+
+    bool isEmpty() const { return m_count == 0; }
+    qsizetype size() const { return m_count; }
+
+    //! Tracks \a item until its reply; it fails with a timeout after \a timeoutMs, if positive.
+    void add(const ItemPtr &item, qint64 timeoutMs = 0);
+    //! Removes the oldest request of the given method; null if there is none.
+    ItemPtr take(quint16 classId, quint16 methodId);
+    template<class T>
+    QSharedPointer<MessagePromise<T>> take(quint16 classId, quint16 methodId)
+    {
+        // The method determines the promise type, so no dynamic cast is needed.
+        return take(classId, methodId).template staticCast<MessagePromise<T>>();
+    }
+
+    //! Fails every request, e.g. when the channel closes.
+    void failAll(const QException &exc);
+
+private:
+    static quint32 key(quint16 classId, quint16 methodId)
+    {
+        return (quint32(classId) << 16) | methodId;
+    }
+    void cancelTimeout(MessageItem *item);
+
+    QHash<quint32, std::deque<ItemPtr>> m_queues;
+    TimerWheel *m_timers = nullptr;
+    qsizetype m_count = 0;
+};
+
+} // namespace qmq::detail
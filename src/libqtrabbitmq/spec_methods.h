@@ -0,0 +1,1498 @@
+// Generated by tools/amqp_codegen.py from tools/amqp0-9-1.xml. Do not edit.
+#pragma once
+
+#include "amqp_codec.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QVariant>
+
+namespace qmq::spec::methods {
+
+namespace connection {
+struct Start
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 10;
+    static constexpr const char *Name = "connection.start";
+
+    quint8 versionMajor = 0;
+    quint8 versionMinor = 0;
+    QVariantHash serverProperties;
+    QByteArray mechanisms;
+    QByteArray locales;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        versionMajor = detail::readValue<quint8>(in, &ok);
+        versionMinor = detail::readValue<quint8>(in, &ok);
+        serverProperties = detail::readTable(in, &ok);
+        mechanisms = detail::readLongStr(in, &ok);
+        locales = detail::readLongStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint8>(out, versionMajor);
+        detail::writeValue<quint8>(out, versionMinor);
+        ok = detail::writeTable(out, serverProperties) && ok;
+        detail::writeLongStr(out, mechanisms);
+        detail::writeLongStr(out, locales);
+        return ok;
+    }
+};
+
+struct StartOk
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 11;
+    static constexpr const char *Name = "connection.start-ok";
+
+    QVariantHash clientProperties;
+    QString mechanism;
+    QByteArray response;
+    QString locale;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        clientProperties = detail::readTable(in, &ok);
+        mechanism = detail::readShortStr(in, &ok);
+        response = detail::readLongStr(in, &ok);
+        locale = detail::readShortStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeTable(out, clientProperties) && ok;
+        ok = detail::writeShortStr(out, mechanism) && ok;
+        detail::writeLongStr(out, response);
+        ok = detail::writeShortStr(out, locale) && ok;
+        return ok;
+    }
+};
+
+struct Secure
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 20;
+    static constexpr const char *Name = "connection.secure";
+
+    QByteArray challenge;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        challenge = detail::readLongStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeLongStr(out, challenge);
+        return true;
+    }
+};
+
+struct SecureOk
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 21;
+    static constexpr const char *Name = "connection.secure-ok";
+
+    QByteArray response;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        response = detail::readLongStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeLongStr(out, response);
+        return true;
+    }
+};
+
+struct Tune
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 30;
+    static constexpr const char *Name = "connection.tune";
+
+    quint16 channelMax = 0;
+    quint32 frameMax = 0;
+    quint16 heartbeat = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        channelMax = detail::readValue<quint16>(in, &ok);
+        frameMax = detail::readValue<quint32>(in, &ok);
+        heartbeat = detail::readValue<quint16>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint16>(out, channelMax);
+        detail::writeValue<quint32>(out, frameMax);
+        detail::writeValue<quint16>(out, heartbeat);
+        return true;
+    }
+};
+
+struct TuneOk
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 31;
+    static constexpr const char *Name = "connection.tune-ok";
+
+    quint16 channelMax = 0;
+    quint32 frameMax = 0;
+    quint16 heartbeat = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        channelMax = detail::readValue<quint16>(in, &ok);
+        frameMax = detail::readValue<quint32>(in, &ok);
+        heartbeat = detail::readValue<quint16>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint16>(out, channelMax);
+        detail::writeValue<quint32>(out, frameMax);
+        detail::writeValue<quint16>(out, heartbeat);
+        return true;
+    }
+};
+
+struct Open
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 40;
+    static constexpr const char *Name = "connection.open";
+
+    QString virtualHost;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        virtualHost = detail::readShortStr(in, &ok);
+        detail::readShortStr(in, &ok); // reserved-1
+        detail::readValue<quint8>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, virtualHost) && ok;
+        ok = detail::writeShortStr(out, QString()) && ok;
+        detail::writeValue<quint8>(out, quint8(0));
+        return ok;
+    }
+};
+
+struct OpenOk
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 41;
+    static constexpr const char *Name = "connection.open-ok";
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readShortStr(in, &ok); // reserved-1
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, QString()) && ok;
+        return ok;
+    }
+};
+
+struct Close
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 50;
+    static constexpr const char *Name = "connection.close";
+
+    quint16 replyCode = 0;
+    QString replyText;
+    quint16 classId = 0;
+    quint16 methodId = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        replyCode = detail::readValue<quint16>(in, &ok);
+        replyText = detail::readShortStr(in, &ok);
+        classId = detail::readValue<quint16>(in, &ok);
+        methodId = detail::readValue<quint16>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, replyCode);
+        ok = detail::writeShortStr(out, replyText) && ok;
+        detail::writeValue<quint16>(out, classId);
+        detail::writeValue<quint16>(out, methodId);
+        return ok;
+    }
+};
+
+struct CloseOk
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 51;
+    static constexpr const char *Name = "connection.close-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Blocked
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 60;
+    static constexpr const char *Name = "connection.blocked";
+
+    QString reason;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        reason = detail::readShortStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, reason) && ok;
+        return ok;
+    }
+};
+
+struct Unblocked
+{
+    static constexpr quint16 ClassId = 10;
+    static constexpr quint16 MethodId = 61;
+    static constexpr const char *Name = "connection.unblocked";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+} // namespace connection
+
+namespace channel {
+struct Open
+{
+    static constexpr quint16 ClassId = 20;
+    static constexpr quint16 MethodId = 10;
+    static constexpr const char *Name = "channel.open";
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readShortStr(in, &ok); // reserved-1
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, QString()) && ok;
+        return ok;
+    }
+};
+
+struct OpenOk
+{
+    static constexpr quint16 ClassId = 20;
+    static constexpr quint16 MethodId = 11;
+    static constexpr const char *Name = "channel.open-ok";
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readLongStr(in, &ok); // reserved-1
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeLongStr(out, QByteArray());
+        return true;
+    }
+};
+
+struct Flow
+{
+    static constexpr quint16 ClassId = 20;
+    static constexpr quint16 MethodId = 20;
+    static constexpr const char *Name = "channel.flow";
+
+    bool active = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            active = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint8>(out, quint8(active ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct FlowOk
+{
+    static constexpr quint16 ClassId = 20;
+    static constexpr quint16 MethodId = 21;
+    static constexpr const char *Name = "channel.flow-ok";
+
+    bool active = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            active = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint8>(out, quint8(active ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct Close
+{
+    static constexpr quint16 ClassId = 20;
+    static constexpr quint16 MethodId = 40;
+    static constexpr const char *Name = "channel.close";
+
+    quint16 replyCode = 0;
+    QString replyText;
+    quint16 classId = 0;
+    quint16 methodId = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        replyCode = detail::readValue<quint16>(in, &ok);
+        replyText = detail::readShortStr(in, &ok);
+        classId = detail::readValue<quint16>(in, &ok);
+        methodId = detail::readValue<quint16>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, replyCode);
+        ok = detail::writeShortStr(out, replyText) && ok;
+        detail::writeValue<quint16>(out, classId);
+        detail::writeValue<quint16>(out, methodId);
+        return ok;
+    }
+};
+
+struct CloseOk
+{
+    static constexpr quint16 ClassId = 20;
+    static constexpr quint16 MethodId = 41;
+    static constexpr const char *Name = "channel.close-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+} // namespace channel
+
+namespace exchange {
+struct Declare
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 10;
+    static constexpr const char *Name = "exchange.declare";
+
+    QString exchange;
+    QString type;
+    bool passive = false;
+    bool durable = false;
+    bool autoDelete = false;
+    bool internal = false;
+    bool noWait = false;
+    QVariantHash arguments;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        exchange = detail::readShortStr(in, &ok);
+        type = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            passive = (bits & 0x01) != 0;
+            durable = (bits & 0x02) != 0;
+            autoDelete = (bits & 0x04) != 0;
+            internal = (bits & 0x08) != 0;
+            noWait = (bits & 0x10) != 0;
+        }
+        arguments = detail::readTable(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, exchange) && ok;
+        ok = detail::writeShortStr(out, type) && ok;
+        detail::writeValue<quint8>(out,
+                                   quint8((passive ? 0x01 : 0)
+                                        | (durable ? 0x02 : 0)
+                                        | (autoDelete ? 0x04 : 0)
+                                        | (internal ? 0x08 : 0)
+                                        | (noWait ? 0x10 : 0)));
+        ok = detail::writeTable(out, arguments) && ok;
+        return ok;
+    }
+};
+
+struct DeclareOk
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 11;
+    static constexpr const char *Name = "exchange.declare-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Delete
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 20;
+    static constexpr const char *Name = "exchange.delete";
+
+    QString exchange;
+    bool ifUnused = false;
+    bool noWait = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        exchange = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            ifUnused = (bits & 0x01) != 0;
+            noWait = (bits & 0x02) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, exchange) && ok;
+        detail::writeValue<quint8>(out,
+                                   quint8((ifUnused ? 0x01 : 0)
+                                        | (noWait ? 0x02 : 0)));
+        return ok;
+    }
+};
+
+struct DeleteOk
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 21;
+    static constexpr const char *Name = "exchange.delete-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Bind
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 30;
+    static constexpr const char *Name = "exchange.bind";
+
+    QString destination;
+    QString source;
+    QString routingKey;
+    bool noWait = false;
+    QVariantHash arguments;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        destination = detail::readShortStr(in, &ok);
+        source = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            noWait = (bits & 0x01) != 0;
+        }
+        arguments = detail::readTable(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, destination) && ok;
+        ok = detail::writeShortStr(out, source) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        detail::writeValue<quint8>(out, quint8(noWait ? 0x01 : 0));
+        ok = detail::writeTable(out, arguments) && ok;
+        return ok;
+    }
+};
+
+struct BindOk
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 31;
+    static constexpr const char *Name = "exchange.bind-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Unbind
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 40;
+    static constexpr const char *Name = "exchange.unbind";
+
+    QString destination;
+    QString source;
+    QString routingKey;
+    bool noWait = false;
+    QVariantHash arguments;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        destination = detail::readShortStr(in, &ok);
+        source = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            noWait = (bits & 0x01) != 0;
+        }
+        arguments = detail::readTable(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, destination) && ok;
+        ok = detail::writeShortStr(out, source) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        detail::writeValue<quint8>(out, quint8(noWait ? 0x01 : 0));
+        ok = detail::writeTable(out, arguments) && ok;
+        return ok;
+    }
+};
+
+struct UnbindOk
+{
+    static constexpr quint16 ClassId = 40;
+    static constexpr quint16 MethodId = 51;
+    static constexpr const char *Name = "exchange.unbind-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+} // namespace exchange
+
+namespace queue {
+struct Declare
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 10;
+    static constexpr const char *Name = "queue.declare";
+
+    QString queue;
+    bool passive = false;
+    bool durable = false;
+    bool exclusive = false;
+    bool autoDelete = false;
+    bool noWait = false;
+    QVariantHash arguments;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        queue = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            passive = (bits & 0x01) != 0;
+            durable = (bits & 0x02) != 0;
+            exclusive = (bits & 0x04) != 0;
+            autoDelete = (bits & 0x08) != 0;
+            noWait = (bits & 0x10) != 0;
+        }
+        arguments = detail::readTable(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, queue) && ok;
+        detail::writeValue<quint8>(out,
+                                   quint8((passive ? 0x01 : 0)
+                                        | (durable ? 0x02 : 0)
+                                        | (exclusive ? 0x04 : 0)
+                                        | (autoDelete ? 0x08 : 0)
+                                        | (noWait ? 0x10 : 0)));
+        ok = detail::writeTable(out, arguments) && ok;
+        return ok;
+    }
+};
+
+struct DeclareOk
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 11;
+    static constexpr const char *Name = "queue.declare-ok";
+
+    QString queue;
+    quint32 messageCount = 0;
+    quint32 consumerCount = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        queue = detail::readShortStr(in, &ok);
+        messageCount = detail::readValue<quint32>(in, &ok);
+        consumerCount = detail::readValue<quint32>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, queue) && ok;
+        detail::writeValue<quint32>(out, messageCount);
+        detail::writeValue<quint32>(out, consumerCount);
+        return ok;
+    }
+};
+
+struct Bind
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 20;
+    static constexpr const char *Name = "queue.bind";
+
+    QString queue;
+    QString exchange;
+    QString routingKey;
+    bool noWait = false;
+    QVariantHash arguments;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        queue = detail::readShortStr(in, &ok);
+        exchange = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            noWait = (bits & 0x01) != 0;
+        }
+        arguments = detail::readTable(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, queue) && ok;
+        ok = detail::writeShortStr(out, exchange) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        detail::writeValue<quint8>(out, quint8(noWait ? 0x01 : 0));
+        ok = detail::writeTable(out, arguments) && ok;
+        return ok;
+    }
+};
+
+struct BindOk
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 21;
+    static constexpr const char *Name = "queue.bind-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Unbind
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 50;
+    static constexpr const char *Name = "queue.unbind";
+
+    QString queue;
+    QString exchange;
+    QString routingKey;
+    QVariantHash arguments;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        queue = detail::readShortStr(in, &ok);
+        exchange = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        arguments = detail::readTable(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, queue) && ok;
+        ok = detail::writeShortStr(out, exchange) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        ok = detail::writeTable(out, arguments) && ok;
+        return ok;
+    }
+};
+
+struct UnbindOk
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 51;
+    static constexpr const char *Name = "queue.unbind-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Purge
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 30;
+    static constexpr const char *Name = "queue.purge";
+
+    QString queue;
+    bool noWait = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        queue = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            noWait = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, queue) && ok;
+        detail::writeValue<quint8>(out, quint8(noWait ? 0x01 : 0));
+        return ok;
+    }
+};
+
+struct PurgeOk
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 31;
+    static constexpr const char *Name = "queue.purge-ok";
+
+    quint32 messageCount = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        messageCount = detail::readValue<quint32>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint32>(out, messageCount);
+        return true;
+    }
+};
+
+struct Delete
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 40;
+    static constexpr const char *Name = "queue.delete";
+
+    QString queue;
+    bool ifUnused = false;
+    bool ifEmpty = false;
+    bool noWait = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        queue = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            ifUnused = (bits & 0x01) != 0;
+            ifEmpty = (bits & 0x02) != 0;
+            noWait = (bits & 0x04) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, queue) && ok;
+        detail::writeValue<quint8>(out,
+                                   quint8((ifUnused ? 0x01 : 0)
+                                        | (ifEmpty ? 0x02 : 0)
+                                        | (noWait ? 0x04 : 0)));
+        return ok;
+    }
+};
+
+struct DeleteOk
+{
+    static constexpr quint16 ClassId = 50;
+    static constexpr quint16 MethodId = 41;
+    static constexpr const char *Name = "queue.delete-ok";
+
+    quint32 messageCount = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        messageCount = detail::readValue<quint32>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint32>(out, messageCount);
+        return true;
+    }
+};
+} // namespace queue
+
+namespace basic {
+struct Qos
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 10;
+    static constexpr const char *Name = "basic.qos";
+
+    quint32 prefetchSize = 0;
+    quint16 prefetchCount = 0;
+    bool global = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        prefetchSize = detail::readValue<quint32>(in, &ok);
+        prefetchCount = detail::readValue<quint16>(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            global = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint32>(out, prefetchSize);
+        detail::writeValue<quint16>(out, prefetchCount);
+        detail::writeValue<quint8>(out, quint8(global ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct QosOk
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 11;
+    static constexpr const char *Name = "basic.qos-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Consume
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 20;
+    static constexpr const char *Name = "basic.consume";
+
+    QString queue;
+    QString consumerTag;
+    bool noLocal = false;
+    bool noAck = false;
+    bool exclusive = false;
+    bool noWait = false;
+    QVariantHash arguments;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        queue = detail::readShortStr(in, &ok);
+        consumerTag = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            noLocal = (bits & 0x01) != 0;
+            noAck = (bits & 0x02) != 0;
+            exclusive = (bits & 0x04) != 0;
+            noWait = (bits & 0x08) != 0;
+        }
+        arguments = detail::readTable(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, queue) && ok;
+        ok = detail::writeShortStr(out, consumerTag) && ok;
+        detail::writeValue<quint8>(out,
+                                   quint8((noLocal ? 0x01 : 0)
+                                        | (noAck ? 0x02 : 0)
+                                        | (exclusive ? 0x04 : 0)
+                                        | (noWait ? 0x08 : 0)));
+        ok = detail::writeTable(out, arguments) && ok;
+        return ok;
+    }
+};
+
+struct ConsumeOk
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 21;
+    static constexpr const char *Name = "basic.consume-ok";
+
+    QString consumerTag;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        consumerTag = detail::readShortStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, consumerTag) && ok;
+        return ok;
+    }
+};
+
+struct Cancel
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 30;
+    static constexpr const char *Name = "basic.cancel";
+
+    QString consumerTag;
+    bool noWait = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        consumerTag = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            noWait = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, consumerTag) && ok;
+        detail::writeValue<quint8>(out, quint8(noWait ? 0x01 : 0));
+        return ok;
+    }
+};
+
+struct CancelOk
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 31;
+    static constexpr const char *Name = "basic.cancel-ok";
+
+    QString consumerTag;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        consumerTag = detail::readShortStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, consumerTag) && ok;
+        return ok;
+    }
+};
+
+struct Publish
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 40;
+    static constexpr const char *Name = "basic.publish";
+
+    QString exchange;
+    QString routingKey;
+    bool mandatory = false;
+    bool immediate = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        exchange = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            mandatory = (bits & 0x01) != 0;
+            immediate = (bits & 0x02) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, exchange) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        detail::writeValue<quint8>(out,
+                                   quint8((mandatory ? 0x01 : 0)
+                                        | (immediate ? 0x02 : 0)));
+        return ok;
+    }
+};
+
+struct Return
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 50;
+    static constexpr const char *Name = "basic.return";
+
+    quint16 replyCode = 0;
+    QString replyText;
+    QString exchange;
+    QString routingKey;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        replyCode = detail::readValue<quint16>(in, &ok);
+        replyText = detail::readShortStr(in, &ok);
+        exchange = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, replyCode);
+        ok = detail::writeShortStr(out, replyText) && ok;
+        ok = detail::writeShortStr(out, exchange) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        return ok;
+    }
+};
+
+struct Deliver
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 60;
+    static constexpr const char *Name = "basic.deliver";
+
+    QString consumerTag;
+    quint64 deliveryTag = 0;
+    bool redelivered = false;
+    QString exchange;
+    QString routingKey;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        consumerTag = detail::readShortStr(in, &ok);
+        deliveryTag = detail::readValue<quint64>(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            redelivered = (bits & 0x01) != 0;
+        }
+        exchange = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, consumerTag) && ok;
+        detail::writeValue<quint64>(out, deliveryTag);
+        detail::writeValue<quint8>(out, quint8(redelivered ? 0x01 : 0));
+        ok = detail::writeShortStr(out, exchange) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        return ok;
+    }
+};
+
+struct Get
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 70;
+    static constexpr const char *Name = "basic.get";
+
+    QString queue;
+    bool noAck = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readValue<quint16>(in, &ok); // reserved-1
+        queue = detail::readShortStr(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            noAck = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint16>(out, quint16(0));
+        ok = detail::writeShortStr(out, queue) && ok;
+        detail::writeValue<quint8>(out, quint8(noAck ? 0x01 : 0));
+        return ok;
+    }
+};
+
+struct GetOk
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 71;
+    static constexpr const char *Name = "basic.get-ok";
+
+    quint64 deliveryTag = 0;
+    bool redelivered = false;
+    QString exchange;
+    QString routingKey;
+    quint32 messageCount = 0;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        deliveryTag = detail::readValue<quint64>(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            redelivered = (bits & 0x01) != 0;
+        }
+        exchange = detail::readShortStr(in, &ok);
+        routingKey = detail::readShortStr(in, &ok);
+        messageCount = detail::readValue<quint32>(in, &ok);
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        detail::writeValue<quint64>(out, deliveryTag);
+        detail::writeValue<quint8>(out, quint8(redelivered ? 0x01 : 0));
+        ok = detail::writeShortStr(out, exchange) && ok;
+        ok = detail::writeShortStr(out, routingKey) && ok;
+        detail::writeValue<quint32>(out, messageCount);
+        return ok;
+    }
+};
+
+struct GetEmpty
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 72;
+    static constexpr const char *Name = "basic.get-empty";
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        detail::readShortStr(in, &ok); // reserved-1
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        bool ok = true;
+        ok = detail::writeShortStr(out, QString()) && ok;
+        return ok;
+    }
+};
+
+struct Ack
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 80;
+    static constexpr const char *Name = "basic.ack";
+
+    quint64 deliveryTag = 0;
+    bool multiple = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        deliveryTag = detail::readValue<quint64>(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            multiple = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint64>(out, deliveryTag);
+        detail::writeValue<quint8>(out, quint8(multiple ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct Reject
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 90;
+    static constexpr const char *Name = "basic.reject";
+
+    quint64 deliveryTag = 0;
+    bool requeue = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        deliveryTag = detail::readValue<quint64>(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            requeue = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint64>(out, deliveryTag);
+        detail::writeValue<quint8>(out, quint8(requeue ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct RecoverAsync
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 100;
+    static constexpr const char *Name = "basic.recover-async";
+
+    bool requeue = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            requeue = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint8>(out, quint8(requeue ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct Recover
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 110;
+    static constexpr const char *Name = "basic.recover";
+
+    bool requeue = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            requeue = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint8>(out, quint8(requeue ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct RecoverOk
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 111;
+    static constexpr const char *Name = "basic.recover-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Nack
+{
+    static constexpr quint16 ClassId = 60;
+    static constexpr quint16 MethodId = 120;
+    static constexpr const char *Name = "basic.nack";
+
+    quint64 deliveryTag = 0;
+    bool multiple = false;
+    bool requeue = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        deliveryTag = detail::readValue<quint64>(in, &ok);
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            multiple = (bits & 0x01) != 0;
+            requeue = (bits & 0x02) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint64>(out, deliveryTag);
+        detail::writeValue<quint8>(out,
+                                   quint8((multiple ? 0x01 : 0)
+                                        | (requeue ? 0x02 : 0)));
+        return true;
+    }
+};
+} // namespace basic
+
+namespace confirm {
+struct Select
+{
+    static constexpr quint16 ClassId = 85;
+    static constexpr quint16 MethodId = 10;
+    static constexpr const char *Name = "confirm.select";
+
+    bool nowait = false;
+
+    bool decode(detail::ByteCursor *in)
+    {
+        bool ok = true;
+        {
+            const quint8 bits = detail::readValue<quint8>(in, &ok);
+            nowait = (bits & 0x01) != 0;
+        }
+        return ok;
+    }
+    bool encode(detail::ByteWriter *out) const
+    {
+        detail::writeValue<quint8>(out, quint8(nowait ? 0x01 : 0));
+        return true;
+    }
+};
+
+struct SelectOk
+{
+    static constexpr quint16 ClassId = 85;
+    static constexpr quint16 MethodId = 11;
+    static constexpr const char *Name = "confirm.select-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+} // namespace confirm
+
+namespace tx {
+struct Select
+{
+    static constexpr quint16 ClassId = 90;
+    static constexpr quint16 MethodId = 10;
+    static constexpr const char *Name = "tx.select";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct SelectOk
+{
+    static constexpr quint16 ClassId = 90;
+    static constexpr quint16 MethodId = 11;
+    static constexpr const char *Name = "tx.select-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Commit
+{
+    static constexpr quint16 ClassId = 90;
+    static constexpr quint16 MethodId = 20;
+    static constexpr const char *Name = "tx.commit";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct CommitOk
+{
+    static constexpr quint16 ClassId = 90;
+    static constexpr quint16 MethodId = 21;
+    static constexpr const char *Name = "tx.commit-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct Rollback
+{
+    static constexpr quint16 ClassId = 90;
+    static constexpr quint16 MethodId = 30;
+    static constexpr const char *Name = "tx.rollback";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+
+struct RollbackOk
+{
+    static constexpr quint16 ClassId = 90;
+    static constexpr quint16 MethodId = 31;
+    static constexpr const char *Name = "tx.rollback-ok";
+
+    bool decode(detail::ByteCursor *) { return true; }
+    bool encode(detail::ByteWriter *) const { return true; }
+};
+} // namespace tx
+
+} // namespace qmq::spec::methods
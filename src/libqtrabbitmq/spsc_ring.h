@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace qmq::detail {
+
+//! Bounded queue for exactly one producer thread and one consumer thread.
+//!
+//! Head and tail only ever grow; a slot is (index & mask). The producer publishes a slot with a
+//! release store of the tail and the consumer frees it with a release store of the head, so no
+//! lock is taken on either side. They live on separate cache lines to avoid false sharing.
+template<typename T>
+class SpscRing
+{
+public:
+    //! \a capacity is rounded up to a power of two.
+    explicit SpscRing(size_t capacity)
+        : m_slots(roundUp(capacity))
+        , m_mask(m_slots.size() - 1)
+    {}
+
+    size_t capacity() const { return m_slots.size(); }
+
+    //! Producer side. Leaves \a value untouched and returns false when the ring is full.
+    bool tryPush(T &&value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Consumer side.
+    bool tryPop(T *value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        T &slot = m_slots[head & m_mask];
+        *value = std::move(slot);
+        // Drop anything the moved-from slot still holds before it is handed back.
+        slot = T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t roundUp(size_t n)
+    {
+        size_t c = 2;
+        while (c < n) {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    std::vector<T> m_slots;
+    const size_t m_mask;
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+} // namespace qmq::detail
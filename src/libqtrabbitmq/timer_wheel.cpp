@@ -0,0 +1,219 @@
+#include "timer_wheel.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+namespace qmq::detail {
+
+TimerWheel::TimerWheel(int tickMs)
+    : m_tickMs(qMax(tickMs, 1))
+{
+    m_clock.start();
+    for (auto &level : m_heads) {
+        std::fill(std::begin(level), std::end(level), -1);
+    }
+}
+
+TimerWheel::TimerId TimerWheel::start(qint64 delayMs, Callback callback)
+{
+    int index = m_freeList;
+    if (index >= 0) {
+        m_freeList = m_nodes[index].next;
+    } else {
+        index = int(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    Node &node = m_nodes[index];
+    const qint64 dueMs = now() + qMax<qint64>(delayMs, 0);
+    node.expiry = qMax(quint64((dueMs + m_tickMs - 1) / m_tickMs), m_tick + 1);
+    node.callback = std::move(callback);
+    place(index);
+    ++m_count;
+
+    const TimerId id = makeId(index, node.generation);
+    if (m_wakeup) {
+        m_wakeup(qMax<qint64>(qint64(node.expiry) * m_tickMs - now(), 0));
+    }
+    return id;
+}
+
+bool TimerWheel::cancel(TimerId id)
+{
+    if (!nodeFor(id)) {
+        return false;
+    }
+    const int index = int(quint32(id)) - 1;
+    unlink(index);
+    release(index);
+    return true;
+}
+
+bool TimerWheel::isActive(TimerId id) const
+{
+    return nodeFor(id) != nullptr;
+}
+
+int TimerWheel::advance()
+{
+    const quint64 target = quint64(now() / m_tickMs);
+    int fired = 0;
+    while (m_tick < target) {
+        if (m_count == 0) {
+            m_tick = target;
+            break;
+        }
+        // Ticks without a due slot or a cascade are skipped in one step.
+        const quint64 next = m_tick + ticksUntilNextEvent();
+        if (next > target) {
+            m_tick = target;
+            break;
+        }
+        m_tick = next;
+        for (int level = 1; level < LevelCount; ++level) {
+            if ((m_tick & ((quint64(1) << (LevelBits * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+
+        const int slot = int(m_tick % SlotCount);
+        std::vector<Callback> due;
+        int index = m_heads[0][slot];
+        m_heads[0][slot] = -1;
+        m_occupied[0] &= ~(quint64(1) << slot);
+        while (index >= 0) {
+            Node &node = m_nodes[index];
+            const int following = node.next;
+            node.level = -1;
+            if (node.expiry > m_tick) {
+                place(index);
+            } else {
+                due.push_back(std::move(node.callback));
+                release(index);
+            }
+            index = following;
+        }
+        // Run the callbacks only once the wheel is consistent again.
+        for (const Callback &callback : due) {
+            callback();
+            ++fired;
+        }
+    }
+    return fired;
+}
+
+qint64 TimerWheel::msUntilNextEvent() const
+{
+    if (m_count == 0) {
+        return -1;
+    }
+    const qint64 dueMs = qint64(m_tick + ticksUntilNextEvent()) * m_tickMs;
+    return qMax<qint64>(dueMs - now(), 0);
+}
+
+const TimerWheel::Node *TimerWheel::nodeFor(TimerId id) const
+{
+    const qint64 index = qint64(quint32(id)) - 1;
+    if (index < 0 || index >= qint64(m_nodes.size())) {
+        return nullptr;
+    }
+    const Node &node = m_nodes[size_t(index)];
+    if (node.generation != quint32(id >> 32) || node.level < 0) {
+        return nullptr;
+    }
+    return &node;
+}
+
+void TimerWheel::place(int index)
+{
+    const Node &node = m_nodes[index];
+    quint64 expiry = node.expiry;
+    if (expiry > m_tick + MaxTicks) {
+        // Beyond the wheel; it is placed again when the last level comes round.
+        expiry = m_tick + MaxTicks;
+    }
+    const quint64 delta = expiry > m_tick ? expiry - m_tick : 0;
+    int level = 0;
+    while (level < LevelCount - 1 && (delta >> (LevelBits * (level + 1))) != 0) {
+        ++level;
+    }
+    link(index, level, int((expiry >> (LevelBits * level)) % SlotCount));
+}
+
+void TimerWheel::link(int index, int level, int slot)
+{
+    Node &node = m_nodes[index];
+    node.level = qint8(level);
+    node.slot = quint8(slot);
+    node.prev = -1;
+    node.next = m_heads[level][slot];
+    if (node.next >= 0) {
+        m_nodes[node.next].prev = index;
+    }
+    m_heads[level][slot] = index;
+    m_occupied[level] |= quint64(1) << slot;
+}
+
+void TimerWheel::unlink(int index)
+{
+    Node &node = m_nodes[index];
+    if (node.prev >= 0) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_heads[node.level][node.slot] = node.next;
+        if (node.next < 0) {
+            m_occupied[node.level] &= ~(quint64(1) << node.slot);
+        }
+    }
+    if (node.next >= 0) {
+        m_nodes[node.next].prev = node.prev;
+    }
+    node.level = -1;
+}
+
+void TimerWheel::release(int index)
+{
+    Node &node = m_nodes[index];
+    node.callback = nullptr;
+    node.level = -1;
+    ++node.generation;
+    node.next = m_freeList;
+    m_freeList = index;
+    --m_count;
+}
+
+void TimerWheel::cascade(int level)
+{
+    const int slot = int((m_tick >> (LevelBits * level)) % SlotCount);
+    int index = m_heads[level][slot];
+    m_heads[level][slot] = -1;
+    m_occupied[level] &= ~(quint64(1) << slot);
+    while (index >= 0) {
+        const int next = m_nodes[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+quint64 TimerWheel::ticksUntilNextEvent() const
+{
+    quint64 best = MaxTicks + 1;
+    for (int level = 0; level < LevelCount; ++level) {
+        const quint64 occupied = m_occupied[level];
+        if (occupied == 0) {
+            continue;
+        }
+        // The first occupied slot after the current one, going round the level.
+        const int shift = LevelBits * level;
+        const quint64 position = m_tick >> shift;
+        const int from = int((position + 1) % SlotCount);
+        const quint64 rotated = from == 0 ? occupied
+                                          : (occupied >> from) | (occupied << (SlotCount - from));
+        const quint64 slots = qCountTrailingZeroBits(rotated) + 1;
+        best = qMin(best, ((position + slots) << shift) - m_tick);
+    }
+    return best;
+}
+
+} // namespace qmq::detail
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <qglobal.h>
+
+#include <functional>
+#include <vector>
+
+namespace qmq::detail {
+
+//! Timeouts of a connection, without a QTimer per timeout.
+//!
+//! A hierarchical wheel of four levels with 64 slots each. Level 0 slots are one tick wide, and
+//! every level above is 64 times coarser, so 10 ms ticks cover about 4.6 hours; later timeouts
+//! wait in the last level and are placed again when it comes round. Each slot is a doubly
+//! linked list of nodes in a pool, so start() and cancel() are O(1). A timer moves down a
+//! level when the wheel reaches its slot and fires from level 0.
+//!
+//! The wheel does not wait by itself: the owner calls advance() once msUntilNextEvent() has
+//! passed, and re-arms its single timer when the wakeup handler reports an earlier timeout.
+class TimerWheel
+{
+public:
+    //! Identifies a started timer; 0 is never used. Ids of fired or cancelled timers are not
+    //! reused, so cancelling one late is harmless.
+    using TimerId = quint64;
+    using Callback = std::function<void()>;
+
+    explicit TimerWheel(int tickMs = 10);
+
+    int tickMs() const { return m_tickMs; }
+    //! Milliseconds since the wheel was created.
+    qint64 now() const { return m_clock.elapsed(); }
+
+    //! Runs \a callback once \a delayMs have passed, rounded up to a whole tick.
+    TimerId start(qint64 delayMs, Callback callback);
+    //! False if the timer has fired or was cancelled already.
+    bool cancel(TimerId id);
+    bool isActive(TimerId id) const;
+    qsizetype size() const { return m_count; }
+
+    //! Fires the timers that are due and returns how many there were. Callbacks may start and
+    //! cancel timers.
+    int advance();
+    //! Time until advance() has something to do, 0 if it is due, or -1 if no timer is pending.
+    qint64 msUntilNextEvent() const;
+
+    //! Called by start() with the delay of the new timer, so that the owner can wake up
+    //! earlier than it planned to.
+    void setWakeupHandler(std::function<void(qint64 delayMs)> handler)
+    {
+        m_wakeup = std::move(handler);
+    }
+
+private:
+    static constexpr int LevelBits = 6;
+    static constexpr int SlotCount = 1 << LevelBits;
+    static constexpr int LevelCount = 4;
+    static constexpr quint64 MaxTicks = (quint64(1) << (LevelBits * LevelCount)) - 1;
+
+    struct Node
+    {
+        Callback callback;
+        quint64 expiry = 0;
+        quint32 generation = 0;
+        int prev = -1;
+        int next = -1;
+        qint8 level = -1;
+        quint8 slot = 0;
+    };
+
+    static TimerId makeId(int index, quint32 generation)
+    {
+        return (quint64(generation) << 32) | quint32(index + 1);
+    }
+    const Node *nodeFor(TimerId id) const;
+    void place(int index);
+    void link(int index, int level, int slot);
+    void unlink(int index);
+    void release(int index);
+    void cascade(int level);
+    quint64 ticksUntilNextEvent() const;
+
+    QElapsedTimer m_clock;
+    int m_tickMs = 10;
+    quint64 m_tick = 0;
+    std::vector<Node> m_nodes;
+    int m_freeList = -1;
+    int m_heads[LevelCount][SlotCount];
+    // Bit s of m_occupied[l] is set while slot s of level l holds a timer.
+    quint64 m_occupied[LevelCount] = {};
+    qsizetype m_count = 0;
+    std::function<void(qint64)> m_wakeup;
+};
+
+} // namespace qmq::detail
@@ -0,0 +1,215 @@
+#include <qtrabbitmq/topology.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <cmath>
+
+namespace {
+
+//! JSON numbers are doubles; brokers want integers for arguments such as x-message-ttl.
+QVariant argumentValue(const QJsonValue &value)
+{
+    switch (value.type()) {
+    case QJsonValue::Double: {
+        const double number = value.toDouble();
+        if (std::trunc(number) == number && std::abs(number) < 9.0e15) {
+            return QVariant::fromValue(qint64(number));
+        }
+        return number;
+    }
+    case QJsonValue::Object: {
+        QVariantHash table;
+        const QJsonObject object = value.toObject();
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            table.insert(it.key(), argumentValue(it.value()));
+        }
+        return table;
+    }
+    case QJsonValue::Array: {
+        QVariantList list;
+        for (const QJsonValue &element : value.toArray()) {
+            list.append(argumentValue(element));
+        }
+        return list;
+    }
+    default:
+        return value.toVariant();
+    }
+}
+
+QVariantHash arguments(const QJsonObject &object)
+{
+    return argumentValue(object.value(QStringLiteral("arguments"))).toHash();
+}
+
+bool exchangeType(const QString &name, qmq::Channel::ExchangeType *type)
+{
+    if (name == QLatin1String("direct")) {
+        *type = qmq::Channel::ExchangeType::Direct;
+    } else if (name == QLatin1String("fanout")) {
+        *type = qmq::Channel::ExchangeType::Fanout;
+    } else if (name == QLatin1String("topic")) {
+        *type = qmq::Channel::ExchangeType::Topic;
+    } else if (name == QLatin1String("headers") || name == QLatin1String("match")) {
+        *type = qmq::Channel::ExchangeType::Headers;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+qmq::Topology failed(QString *errorString, const QString &message)
+{
+    if (errorString) {
+        *errorString = message;
+    }
+    return {};
+}
+
+} // namespace
+
+namespace qmq {
+
+Topology &Topology::addExchange(const QString &name,
+                                Channel::ExchangeType type,
+                                ExchangeDeclareOptions opts,
+                                const QVariantHash &arguments)
+{
+    Item item;
+    item.kind = Item::Kind::Exchange;
+    item.name = name;
+    item.exchangeType = type;
+    item.exchangeOptions = opts;
+    item.arguments = arguments;
+    m_items.append(item);
+    return *this;
+}
+
+Topology &Topology::addQueue(const QString &name,
+                             QueueDeclareOptions opts,
+                             const QVariantHash &arguments)
+{
+    Item item;
+    item.kind = Item::Kind::Queue;
+    item.name = name;
+    item.queueOptions = opts;
+    item.arguments = arguments;
+    m_items.append(item);
+    return *this;
+}
+
+Topology &Topology::addQueueBinding(const QString &queue,
+                                    const QString &exchange,
+                                    const QString &routingKey,
+                                    const QVariantHash &arguments)
+{
+    Item item;
+    item.kind = Item::Kind::QueueBinding;
+    item.name = queue;
+    item.source = exchange;
+    item.routingKey = routingKey;
+    item.arguments = arguments;
+    m_items.append(item);
+    return *this;
+}
+
+Topology &Topology::addExchangeBinding(const QString &destination,
+                                       const QString &source,
+                                       const QString &routingKey,
+                                       const QVariantHash &arguments)
+{
+    Item item;
+    item.kind = Item::Kind::ExchangeBinding;
+    item.name = destination;
+    item.source = source;
+    item.routingKey = routingKey;
+    item.arguments = arguments;
+    m_items.append(item);
+    return *this;
+}
+
+Topology Topology::fromJson(const QJsonObject &definitions, QString *errorString)
+{
+    Topology topology;
+    for (const QJsonValue &value : definitions.value(QStringLiteral("exchanges")).toArray()) {
+        const QJsonObject object = value.toObject();
+        const QString name = object.value(QStringLiteral("name")).toString();
+        Channel::ExchangeType type;
+        if (!exchangeType(object.value(QStringLiteral("type")).toString(), &type)) {
+            return failed(errorString, QStringLiteral("Unknown type of exchange ") + name);
+        }
+        ExchangeDeclareOptions opts;
+        opts.setFlag(ExchangeDeclareOption::Durable,
+                     object.value(QStringLiteral("durable")).toBool());
+        opts.setFlag(ExchangeDeclareOption::AutoDelete,
+                     object.value(QStringLiteral("auto_delete")).toBool());
+        opts.setFlag(ExchangeDeclareOption::Internal,
+                     object.value(QStringLiteral("internal")).toBool());
+        topology.addExchange(name, type, opts, arguments(object));
+    }
+    for (const QJsonValue &value : definitions.value(QStringLiteral("queues")).toArray()) {
+        const QJsonObject object = value.toObject();
+        QueueDeclareOptions opts;
+        opts.setFlag(QueueDeclareOption::Durable, object.value(QStringLiteral("durable")).toBool());
+        opts.setFlag(QueueDeclareOption::Exclusive,
+                     object.value(QStringLiteral("exclusive")).toBool());
+        opts.setFlag(QueueDeclareOption::AutoDelete,
+                     object.value(QStringLiteral("auto_delete")).toBool());
+        topology.addQueue(object.value(QStringLiteral("name")).toString(), opts, arguments(object));
+    }
+    for (const QJsonValue &value : definitions.value(QStringLiteral("bindings")).toArray()) {
+        const QJsonObject object = value.toObject();
+        const QString destination = object.value(QStringLiteral("destination")).toString();
+        const QString source = object.value(QStringLiteral("source")).toString();
+        const QString routingKey = object.value(QStringLiteral("routing_key")).toString();
+        const QString destinationType = object.value(QStringLiteral("destination_type"))
+                                            .toString(QStringLiteral("queue"));
+        if (destinationType == QLatin1String("queue")) {
+            topology.addQueueBinding(destination, source, routingKey, arguments(object));
+        } else if (destinationType == QLatin1String("exchange")) {
+            topology.addExchangeBinding(destination, source, routingKey, arguments(object));
+        } else {
+            return failed(errorString,
+                          QStringLiteral("Unknown binding destination type ") + destinationType);
+        }
+    }
+    return topology;
+}
+
+Topology Topology::fromJson(const QByteArray &json, QString *errorString)
+{
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+    if (document.isNull()) {
+        return failed(errorString, error.errorString());
+    }
+    if (!document.isObject()) {
+        return failed(errorString, QStringLiteral("Topology JSON is not an object"));
+    }
+    return fromJson(document.object(), errorString);
+}
+
+bool TopologyResult::isOk() const
+{
+    for (const ItemResult &result : m_results) {
+        if (!result.isOk()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<TopologyResult::ItemResult> TopologyResult::failures() const
+{
+    QList<ItemResult> result;
+    for (const ItemResult &itemResult : m_results) {
+        if (!itemResult.isOk()) {
+            result.append(itemResult);
+        }
+    }
+    return result;
+}
+
+} // namespace qmq
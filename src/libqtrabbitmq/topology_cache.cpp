@@ -0,0 +1,74 @@
+#include "topology_cache.h"
+
+#include <QDataStream>
+#include <QIODevice>
+
+#include <algorithm>
+
+namespace {
+
+void writeCanonical(QDataStream &out, const QVariant &value)
+{
+    if (value.metaType() == QMetaType::fromType<QVariantHash>()) {
+        const QVariantHash table = value.toHash();
+        QStringList keys = table.keys();
+        std::sort(keys.begin(), keys.end());
+        out << quint8('T') << quint32(keys.size());
+        for (const QString &key : std::as_const(keys)) {
+            out << key;
+            writeCanonical(out, table.value(key));
+        }
+    } else if (value.metaType() == QMetaType::fromType<QVariantList>()) {
+        const QVariantList list = value.toList();
+        out << quint8('A') << quint32(list.size());
+        for (const QVariant &element : list) {
+            writeCanonical(out, element);
+        }
+    } else {
+        out << quint8('V') << value;
+    }
+}
+
+} // namespace
+
+namespace qmq::detail {
+
+QByteArray TopologyCache::key(Kind kind,
+                              const QString &name,
+                              const QString &other,
+                              const QString &routingKey,
+                              int options,
+                              const QVariantHash &arguments)
+{
+    QByteArray result;
+    QDataStream out(&result, QIODevice::WriteOnly);
+    out << quint8(kind) << name << other << routingKey << qint32(options);
+    writeCanonical(out, QVariant(arguments));
+    return result;
+}
+
+void TopologyCache::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if (!enabled) {
+        m_entries.clear();
+    }
+}
+
+const QVariantList *TopologyCache::find(const QByteArray &key) const
+{
+    if (!m_enabled) {
+        return nullptr;
+    }
+    const auto it = m_entries.constFind(key);
+    return it == m_entries.constEnd() ? nullptr : &it.value();
+}
+
+void TopologyCache::insert(const QByteArray &key, const QVariantList &reply)
+{
+    if (m_enabled) {
+        m_entries.insert(key, reply);
+    }
+}
+
+} // namespace qmq::detail
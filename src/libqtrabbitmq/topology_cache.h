@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVariantHash>
+#include <QVariantList>
+
+namespace qmq::detail {
+
+//! Declarations a connection has already made, so that identical ones can be answered locally.
+//!
+//! The key covers the kind of entity, its names, its options and its arguments; arguments are
+//! serialized with sorted keys, so equal hashes give equal keys. For queues the reply of the
+//! first declaration is kept and returned again, message and consumer counts included.
+class TopologyCache
+{
+public:
+    enum class Kind : char { Exchange = 'e', Queue = 'q', QueueBinding = 'b', ExchangeBinding = 'x' };
+
+    static QByteArray key(Kind kind,
+                          const QString &name,
+                          const QString &other,
+                          const QString &routingKey,
+                          int options,
+                          const QVariantHash &arguments);
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+
+    //! The cached reply, or nullptr if \a key has not been declared.
+    const QVariantList *find(const QByteArray &key) const;
+    void insert(const QByteArray &key, const QVariantList &reply = QVariantList());
+    void clear() { m_entries.clear(); }
+    qsizetype size() const { return m_entries.size(); }
+
+private:
+    bool m_enabled = false;
+    QHash<QByteArray, QVariantList> m_entries;
+};
+
+} // namespace qmq::detail
@@ -1,10 +1,34 @@
+#include <qtrabbitmq/ack_batcher.h>
+#include <qtrabbitmq/channel.h>
+#include <qtrabbitmq/client.h>
+#include <qtrabbitmq/consumer.h>
 #include <qtrabbitmq/decimal.h>
+#include <qtrabbitmq/exception.h>
 #include <qtrabbitmq/message.h>
 #include <qtrabbitmq/qtrabbitmq.h>
+#include <qtrabbitmq/topology.h>
+
+#include "amqp_codec.h"
+#include "channel_table.h"
+#include "client_p.h"
+#include "confirm_tracker.h"
+#include "connection_handler.h"
+#include "frame_writer.h"
+#include "rpc_tracker.h"
+#include "spec_constants.h"
+#include "spec_methods.h"
+#include "spsc_ring.h"
+#include "timer_wheel.h"
+#include "topology_cache.h"
 
 #include <QDebug>
 #include <QHash>
+#include <QHostAddress>
 #include <QObject>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
 #include <QtTest>
 
 class BasicRmqTest : public QObject
@@ -88,6 +112,497 @@ private slots:
         // Test debug operator too.
         qDebug() << "Message" << m1;
     }
+    void testConsumerBatchedDelivery()
+    {
+        qmq::Consumer consumer("batched");
+        consumer.setDeliveryMode(qmq::Consumer::DeliveryMode::Batched);
+        consumer.setBatchMaxMessages(4);
+        QSignalSpy singleSpy(&consumer, &qmq::Consumer::messageReady);
+        QSignalSpy batchSpy(&consumer, &qmq::Consumer::messagesReady);
+
+        // A full batch is signalled at once.
+        for (int i = 0; i < 6; ++i) {
+            consumer.pushMessage(qmq::Message(QByteArray::number(i), "ex"));
+        }
+        QCOMPARE(batchSpy.count(), 1);
+        QCOMPARE(batchSpy.at(0).at(0).toInt(), 4);
+
+        // The rest once control returns to the event loop.
+        QVERIFY(batchSpy.wait(1000));
+        QCOMPARE(batchSpy.count(), 2);
+        QCOMPARE(batchSpy.at(1).at(0).toInt(), 2);
+        QCOMPARE(singleSpy.count(), 0);
+
+        QCOMPARE(consumer.messageCount(), 6);
+        const QList<qmq::Message> first = consumer.dequeueBatch(4);
+        QCOMPARE(first.size(), 4);
+        QCOMPARE(first.at(0).payload(), QByteArray("0"));
+        QCOMPARE(first.at(3).payload(), QByteArray("3"));
+        const QList<qmq::Message> rest = consumer.dequeueBatch();
+        QCOMPARE(rest.size(), 2);
+        QCOMPARE(rest.at(1).payload(), QByteArray("5"));
+        QVERIFY(!consumer.hasMessage());
+        QVERIFY(consumer.dequeueBatch().isEmpty());
+    }
+
+    void testSpscRing()
+    {
+        qmq::detail::SpscRing<QByteArray> ring(3);
+        QCOMPARE(ring.capacity(), size_t(4));
+        QVERIFY(ring.isEmpty());
+        for (int i = 0; i < 4; ++i) {
+            QVERIFY(ring.tryPush(QByteArray::number(i)));
+        }
+        QByteArray extra("4");
+        QVERIFY(!ring.tryPush(std::move(extra)));
+        QCOMPARE(extra, QByteArray("4"));
+
+        QByteArray value;
+        QVERIFY(ring.tryPop(&value));
+        QCOMPARE(value, QByteArray("0"));
+        QVERIFY(ring.tryPush(std::move(extra)));
+
+        // Across threads every value arrives once and in order.
+        qmq::detail::SpscRing<int> numbers(64);
+        const int count = 100000;
+        QThread *producer = QThread::create([&numbers]() {
+            for (int i = 0; i < count; ++i) {
+                int v = i;
+                while (!numbers.tryPush(std::move(v))) {
+                    QThread::yieldCurrentThread();
+                }
+            }
+        });
+        producer->start();
+        int expected = 0;
+        int popped = 0;
+        bool isInOrder = true;
+        while (expected < count) {
+            if (numbers.tryPop(&popped)) {
+                isInOrder = isInOrder && popped == expected;
+                ++expected;
+            }
+        }
+        producer->wait();
+        delete producer;
+        QVERIFY(isInOrder);
+        QVERIFY(numbers.isEmpty());
+    }
+
+    void testChannelTable()
+    {
+        qmq::detail::ChannelTable table;
+        QCOMPARE(table.find(1), nullptr);
+        QCOMPARE(table.find(65535), nullptr);
+
+        // Ids are handed out in turn, skipping those in use, across bitmap words.
+        const quint16 maxId = 130;
+        for (quint16 expected = 1; expected <= maxId; ++expected) {
+            const quint16 id = table.allocate(maxId);
+            QCOMPARE(id, expected);
+            QSharedPointer<qmq::Channel> channel(new qmq::Channel(nullptr, id));
+            table.insert(id, channel);
+            QCOMPARE(table.find(id), channel.data());
+        }
+        QCOMPARE(table.size(), qsizetype(maxId));
+        QCOMPARE(table.allocate(maxId), quint16(0));
+        QCOMPARE(table.channels().size(), qsizetype(maxId));
+        QCOMPARE(table.channels().at(64)->channelId(), 65);
+
+        // A larger limit makes room, and the search wraps around to it.
+        QCOMPARE(table.allocate(200), quint16(131));
+        QCOMPARE(table.find(131), nullptr);
+        QVERIFY(!table.contains(0));
+    }
+
+    void testTimerWheel()
+    {
+        qmq::detail::TimerWheel wheel(1);
+        QList<int> fired;
+        QCOMPARE(wheel.msUntilNextEvent(), qint64(-1));
+        wheel.start(30, [&]() { fired.append(30); });
+        const auto cancelled = wheel.start(10, [&]() { fired.append(-1); });
+        wheel.start(5, [&]() { fired.append(5); });
+        // Beyond the first level, so it cascades down before firing.
+        wheel.start(100, [&]() { fired.append(100); });
+        QCOMPARE(wheel.size(), qsizetype(4));
+        QVERIFY(wheel.cancel(cancelled));
+        QVERIFY(!wheel.cancel(cancelled));
+        QVERIFY(!wheel.isActive(cancelled));
+        QVERIFY(wheel.msUntilNextEvent() <= 5);
+
+        QVERIFY(QTest::qWaitFor(
+            [&]() {
+                wheel.advance();
+                return wheel.size() == 0;
+            },
+            1000));
+        QCOMPARE(fired, (QList<int>{5, 30, 100}));
+        QCOMPARE(wheel.msUntilNextEvent(), qint64(-1));
+    }
+
+    void testClientWithTimeout()
+    {
+        qmq::Client client;
+        QPromise<int> never;
+        never.start();
+        const QFuture<int> expired = client.withTimeout(never.future(), 10);
+        QVERIFY(QTest::qWaitFor([&]() { return expired.isFinished(); }, 1000));
+        QVERIFY_THROWS_EXCEPTION(qmq::Exception, expired.waitForFinished());
+
+        QPromise<int> quick;
+        quick.start();
+        const QFuture<int> forwarded = client.withTimeout(quick.future(), 1000);
+        quick.addResult(7);
+        quick.finish();
+        QVERIFY(forwarded.isFinished());
+        QCOMPARE(forwarded.result(), 7);
+    }
+
+    void testHeartbeat()
+    {
+        const QByteArray heartbeat = [] {
+            qmq::detail::FrameWriter writer;
+            writer.writeFrame(qmq::HeartbeatFrame());
+            return writer.buffer();
+        }();
+        const QByteArray missedClose = [] {
+            qmq::spec::methods::connection::Close close;
+            close.replyCode = 500;
+            close.replyText = "Missed heartbeats";
+            qmq::detail::FrameWriter writer;
+            writer.writeMethod(0, close);
+            return writer.buffer();
+        }();
+
+        // A broker on the loopback that opens the connection with a one-second heartbeat,
+        // then answers whatever it receives with a heartbeat until it goes quiet.
+        QByteArray received;
+        bool isAnswering = true;
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        connect(&server, &QTcpServer::newConnection, this, [&]() {
+            QTcpSocket *peer = server.nextPendingConnection();
+            connect(peer, &QTcpSocket::readyRead, this, [&, peer]() {
+                received += peer->readAll();
+                if (isAnswering) {
+                    peer->write(heartbeat);
+                }
+            });
+            qmq::spec::methods::connection::Start start;
+            start.versionMinor = 9;
+            start.mechanisms = "PLAIN";
+            start.locales = "en_US";
+            qmq::spec::methods::connection::Tune tune;
+            tune.heartbeat = 1;
+            qmq::detail::FrameWriter writer;
+            writer.writeMethod(0, start);
+            writer.writeMethod(0, tune);
+            writer.writeMethod(0, qmq::spec::methods::connection::OpenOk());
+            peer->write(writer.buffer());
+        });
+
+        qmq::Client client;
+        QSignalSpy connectedSpy(&client, &qmq::Client::connected);
+        QVERIFY(client.connectToHost(
+            QUrl(QString("amqp://localhost:%1/").arg(server.serverPort()))));
+        QVERIFY(connectedSpy.wait(5000));
+
+        // Idle: a heartbeat goes out half an interval after the last write.
+        QTRY_VERIFY_WITH_TIMEOUT(received.contains(heartbeat), 2000);
+
+        // Other frames written more often than that make heartbeats unnecessary.
+        received.clear();
+        QTimer traffic;
+        connect(&traffic, &QTimer::timeout, &client, [&]() {
+            client.sendFrame(qmq::MethodFrame(1, qmq::spec::tx::ID_, qmq::spec::tx::Select));
+        });
+        traffic.start(100);
+        QTest::qWait(1500);
+        traffic.stop();
+        QVERIFY(!received.isEmpty());
+        QVERIFY(!received.contains(heartbeat));
+
+        // Nothing read for two intervals: the client closes the connection.
+        isAnswering = false;
+        QTRY_VERIFY_WITH_TIMEOUT(received.contains(missedClose), 3000);
+    }
+
+    void testFrameError()
+    {
+        qmq::spec::methods::connection::Close close;
+        close.replyCode = qmq::spec::constants::FrameRrror;
+        close.replyText = "Frame error";
+        qmq::detail::FrameWriter expected;
+        expected.writeMethod(0, close);
+
+        // A heartbeat whose frame-end octet is wrong, then a valid one that must be dropped.
+        QByteArray received;
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        connect(&server, &QTcpServer::newConnection, this, [&]() {
+            QTcpSocket *peer = server.nextPendingConnection();
+            connect(peer, &QTcpSocket::readyRead, this, [&, peer]() {
+                received += peer->readAll();
+            });
+            qmq::detail::FrameWriter heartbeat;
+            heartbeat.writeFrame(qmq::HeartbeatFrame());
+            QByteArray bad = heartbeat.buffer();
+            bad.back() = '\0';
+            peer->write(bad + heartbeat.buffer());
+        });
+
+        qmq::Client client;
+        QVERIFY(client.connectToHost(
+            QUrl(QString("amqp://localhost:%1/").arg(server.serverPort()))));
+        QTRY_VERIFY_WITH_TIMEOUT(received.contains(expected.buffer()), 5000);
+    }
+
+    void testRpcTracker()
+    {
+        using Promise = qmq::detail::MessagePromise<int>;
+        auto makeItem = [](quint16 methodId) {
+            QSharedPointer<Promise> item(new Promise(50, methodId));
+            item->start();
+            return item;
+        };
+        qmq::detail::TimerWheel wheel(1);
+        qmq::detail::RpcTracker tracker;
+        tracker.setTimerWheel(&wheel);
+        const auto first = makeItem(10);
+        const auto other = makeItem(20);
+        const auto second = makeItem(10);
+        tracker.add(first, 1);
+        tracker.add(other, 60000);
+        tracker.add(second);
+        QCOMPARE(tracker.size(), qsizetype(3));
+        QCOMPARE(wheel.size(), qsizetype(2));
+
+        // Each method has its own FIFO, and a reply cancels its timeout.
+        QCOMPARE(tracker.take<int>(50, 20), other);
+        QCOMPARE(wheel.size(), qsizetype(1));
+        QVERIFY(tracker.take(50, 30).isNull());
+
+        // The first request times out, and its late reply is swallowed.
+        QTest::qWait(5);
+        QCOMPARE(wheel.advance(), 1);
+        QVERIFY(first->isFinished());
+        QVERIFY_THROWS_EXCEPTION(qmq::Exception, first->promise.future().waitForFinished());
+        QVERIFY(tracker.take(50, 10).isNull());
+        QCOMPARE(tracker.take<int>(50, 10), second);
+        QVERIFY(tracker.isEmpty());
+
+        const auto pending = makeItem(10);
+        tracker.add(pending, 60000);
+        tracker.failAll(qmq::Exception(500, "Channel closed"));
+        QVERIFY(pending->isFinished());
+        QVERIFY(tracker.isEmpty());
+        QCOMPARE(wheel.size(), qsizetype(0));
+    }
+
+    void testTopologyFromJson()
+    {
+        const QByteArray json = R"({
+            "exchanges": [{"name": "orders", "type": "topic", "durable": true,
+                           "auto_delete": false, "internal": true, "arguments": {}}],
+            "queues": [{"name": "orders.eu", "durable": true, "auto_delete": false,
+                        "arguments": {"x-message-ttl": 60000}}],
+            "bindings": [
+                {"source": "orders", "destination": "orders.eu", "destination_type": "queue",
+                 "routing_key": "eu.#", "arguments": {}},
+                {"source": "orders", "destination": "audit", "destination_type": "exchange",
+                 "routing_key": "#"}
+            ]
+        })";
+        QString error;
+        const qmq::Topology topology = qmq::Topology::fromJson(json, &error);
+        QVERIFY2(error.isEmpty(), qPrintable(error));
+        QCOMPARE(topology.size(), qsizetype(4));
+
+        using Kind = qmq::Topology::Item::Kind;
+        const auto &items = topology.items();
+        QCOMPARE(items.at(0).kind, Kind::Exchange);
+        QCOMPARE(items.at(0).exchangeType, qmq::Channel::ExchangeType::Topic);
+        QVERIFY(items.at(0).exchangeOptions.testFlag(qmq::ExchangeDeclareOption::Durable));
+        QVERIFY(!items.at(0).exchangeOptions.testFlag(qmq::ExchangeDeclareOption::AutoDelete));
+        QVERIFY(items.at(0).exchangeOptions.testFlag(qmq::ExchangeDeclareOption::Internal));
+        QCOMPARE(items.at(1).kind, Kind::Queue);
+        QCOMPARE(items.at(1).name, QString("orders.eu"));
+        // Whole numbers become integers, as the broker expects for TTLs.
+        QCOMPARE(items.at(1).arguments.value("x-message-ttl").metaType(),
+                 QMetaType::fromType<qint64>());
+        QCOMPARE(items.at(2).kind, Kind::QueueBinding);
+        QCOMPARE(items.at(2).source, QString("orders"));
+        QCOMPARE(items.at(2).routingKey, QString("eu.#"));
+        QCOMPARE(items.at(3).kind, Kind::ExchangeBinding);
+
+        QVERIFY(qmq::Topology::fromJson(QByteArray(R"({"exchanges": [{"type": "bogus"}]})"), &error)
+                    .isEmpty());
+        QVERIFY(!error.isEmpty());
+    }
+
+    void testTopologyCache()
+    {
+        using Cache = qmq::detail::TopologyCache;
+        QVariantHash first;
+        first.insert("x-message-ttl", 60000);
+        first.insert("x-max-length", 10);
+        QVariantHash second;
+        second.insert("x-max-length", 10);
+        second.insert("x-message-ttl", 60000);
+        const QByteArray key = Cache::key(Cache::Kind::Queue, "q", QString(), QString(), 2, first);
+        QCOMPARE(Cache::key(Cache::Kind::Queue, "q", QString(), QString(), 2, second), key);
+        QVERIFY(Cache::key(Cache::Kind::Queue, "q", QString(), QString(), 0, first) != key);
+        QVERIFY(Cache::key(Cache::Kind::Exchange, "q", QString(), QString(), 2, first) != key);
+
+        Cache cache;
+        cache.setEnabled(true);
+        QVERIFY(!cache.find(key));
+        cache.insert(key, QVariantList{"q", 0, 0});
+        QVERIFY(cache.find(key));
+        QCOMPARE(cache.find(key)->at(0), QVariant("q"));
+        cache.clear();
+        QVERIFY(!cache.find(key));
+
+        cache.insert(key);
+        cache.setEnabled(false);
+        QCOMPARE(cache.size(), qsizetype(0));
+        cache.insert(key);
+        QVERIFY(!cache.find(key));
+    }
+
+    void testBlockedPublishGating()
+    {
+        qmq::Client client;
+        client.setPublishGatingEnabled(true);
+        client.setPublishQueueLimitBytes(1);
+        qmq::Client::Private *clientPrivate = qmq::Client::Private::get(&client);
+        // Corked, with a socket that never connects: released frames stay in the writer.
+        client.setWriteMode(qmq::Client::WriteMode::Corked);
+        clientPrivate->socket = new QSslSocket(&client);
+        auto channel = client.createChannel();
+        const quint16 channelId = quint16(channel->channelId());
+        const auto encoded = [channelId](const auto &method) {
+            qmq::detail::FrameWriter writer;
+            writer.writeMethod(channelId, method);
+            return writer.buffer();
+        };
+        QSignalSpy blockedSpy(&client, &qmq::Client::blocked);
+        QSignalSpy unblockedSpy(&client, &qmq::Client::unblocked);
+
+        qmq::spec::methods::connection::Blocked blocked;
+        blocked.reason = "low on memory";
+        QVERIFY(clientPrivate->connection->handleMethodFrame(
+            qmq::detail::encodeMethod(0, blocked)));
+        QVERIFY(client.isBlocked());
+        QCOMPARE(blockedSpy.count(), 1);
+        QCOMPARE(blockedSpy.at(0).at(0).toString(), QString("low on memory"));
+
+        // Held by the channel rather than written, until the limit is reached.
+        const qmq::Message msg(QByteArray("gated"), "exchange", "key");
+        QVERIFY(channel->basicPublish(msg));
+        QVERIFY(clientPrivate->gatedBytes > 0);
+        QVERIFY(clientPrivate->writer.isEmpty());
+        QVERIFY(!channel->basicPublish(msg));
+
+        // Other commands on the channel queue up behind the publish.
+        const QFuture<void> commit = channel->txCommit();
+        QVERIFY(!commit.isFinished());
+        QVERIFY(clientPrivate->writer.isEmpty());
+
+        QVERIFY(clientPrivate->connection->handleMethodFrame(
+            qmq::detail::encodeMethod(0, qmq::spec::methods::connection::Unblocked())));
+        QVERIFY(!client.isBlocked());
+        QCOMPARE(unblockedSpy.count(), 1);
+        QCOMPARE(clientPrivate->gatedBytes, qint64(0));
+        const QByteArray commitFrame = encoded(qmq::spec::methods::tx::Commit());
+        QVERIFY(clientPrivate->writer.size() > commitFrame.size());
+        QVERIFY(clientPrivate->writer.buffer().endsWith(commitFrame));
+
+        // channel.close writes the held publish first rather than dropping it.
+        clientPrivate->writer.clear();
+        QVERIFY(clientPrivate->connection->handleMethodFrame(
+            qmq::detail::encodeMethod(0, blocked)));
+        QVERIFY(channel->basicPublish(msg));
+        QVERIFY(clientPrivate->writer.isEmpty());
+        channel->channelClose(200, "bye");
+        QCOMPARE(clientPrivate->gatedBytes, qint64(0));
+        qmq::spec::methods::channel::Close close;
+        close.replyCode = 200;
+        close.replyText = "bye";
+        const QByteArray closeFrame = encoded(close);
+        QVERIFY(clientPrivate->writer.size() > closeFrame.size());
+        QVERIFY(clientPrivate->writer.buffer().endsWith(closeFrame));
+    }
+
+    void testConfirmTracker()
+    {
+        qmq::detail::ConfirmTracker tracker;
+        tracker.enable();
+        QCOMPARE(tracker.addPublishes(3), quint64(1));
+        const QFuture<void> single = tracker.watch(2, 1);
+        const quint64 batchStart = tracker.addPublishes(4);
+        QCOMPARE(batchStart, quint64(4));
+        const QFuture<void> batch = tracker.watch(batchStart, 4);
+        const QFuture<void> all = tracker.waitForAll();
+        QCOMPARE(tracker.nextSeqNo(), quint64(8));
+
+        // Out of order single ack; the front stays outstanding.
+        tracker.settle(2, false, true);
+        QVERIFY(single.isFinished());
+        QCOMPARE(tracker.outstandingCount(), qsizetype(7));
+
+        // A range ack settles everything up to its tag.
+        tracker.settle(5, true, true);
+        QVERIFY(!batch.isFinished());
+        QCOMPARE(tracker.outstandingCount(), qsizetype(2));
+
+        tracker.settle(7, false, false);
+        QVERIFY(!batch.isFinished());
+        tracker.settle(6, false, true);
+        QVERIFY(batch.isFinished());
+        QVERIFY_THROWS_EXCEPTION(qmq::Exception, batch.waitForFinished());
+        QVERIFY(all.isFinished());
+        QVERIFY_THROWS_EXCEPTION(qmq::Exception, all.waitForFinished());
+        QCOMPARE(tracker.outstandingCount(), qsizetype(0));
+
+        // Nothing outstanding: the barrier is already satisfied.
+        QVERIFY(tracker.waitForAll().isFinished());
+
+        tracker.addPublishes(1);
+        const QFuture<void> pending = tracker.waitForAll();
+        tracker.failAll(500, "Channel closed");
+        QVERIFY(pending.isFinished());
+        QVERIFY_THROWS_EXCEPTION(qmq::Exception, pending.waitForFinished());
+
+        // A reopened channel starts confirm mode and its numbering over.
+        tracker.addPublishes(2);
+        const QFuture<void> stale = tracker.watch(9, 1);
+        tracker.reset(500, "Channel closed");
+        QVERIFY(stale.isFinished());
+        QVERIFY(!tracker.isEnabled());
+        tracker.enable();
+        QCOMPARE(tracker.nextSeqNo(), quint64(1));
+        QCOMPARE(tracker.outstandingCount(), qsizetype(0));
+        QCOMPARE(tracker.addPublishes(1), quint64(1));
+    }
+
+    void testAckBatcherReset()
+    {
+        qmq::Channel channel(nullptr, 1);
+        qmq::AckBatcher *batcher = channel.ackBatcher();
+        batcher->complete(1);
+        batcher->complete(3);
+        QCOMPARE(batcher->pendingCount(), 2);
+
+        batcher->reset();
+        QCOMPARE(batcher->pendingCount(), 0);
+        // Tags of the reopened channel start at 1 again.
+        batcher->complete(1);
+        QCOMPARE(batcher->pendingCount(), 1);
+        batcher->reset();
+    }
+
     void cleanupTestCase()
     {
         //qDebug("Called after myFirstTest and mySecondTest.");
@@ -0,0 +1,198 @@
+#include <qtrabbitmq/client.h>
+#include <qtrabbitmq/frame.h>
+
+#include "amqp_codec.h"
+#include "spec_constants.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QLoggingCategory>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+#include <QtTest>
+
+namespace {
+const int waitMs = 30000;
+
+//! Serialized stream of \a count heartbeat frames followed by connection.close, which makes
+//! the client emit disconnected() once everything before it has been dispatched.
+QByteArray makeFrameStream(int count)
+{
+    QBuffer io;
+    io.open(QIODevice::WriteOnly);
+    const qmq::HeartbeatFrame heartbeat;
+    for (int i = 0; i < count; ++i) {
+        qmq::Frame::writeFrame(&io, 0, heartbeat);
+    }
+    qmq::MethodFrame close(0, qmq::spec::connection::ID_, qmq::spec::connection::Close);
+    close.setArguments({QVariant::fromValue(quint16(200)),
+                        QString("bye"),
+                        QVariant::fromValue(quint16(0)),
+                        QVariant::fromValue(quint16(0))});
+    qmq::Frame::writeFrame(&io, 0, close);
+    return io.data();
+}
+//! Application headers with 50 entries, a fifth of which are tables nested three deep.
+QVariantHash makeNestedHeaders()
+{
+    QVariantHash headers;
+    for (int i = 0; i < 50; ++i) {
+        const QString key = QString("x-header-%1").arg(i);
+        if (i % 5 != 0) {
+            headers.insert(key, QString("value-%1").arg(i));
+            continue;
+        }
+        QVariantHash nested;
+        for (int depth = 0; depth < 3; ++depth) {
+            QVariantHash outer({{"id", i}, {"depth", depth}, {"name", QString("n%1").arg(i)}});
+            outer.insert("list", QVariantList({1, 2, 3}));
+            if (!nested.isEmpty()) {
+                outer.insert("inner", nested);
+            }
+            nested = outer;
+        }
+        headers.insert(key, nested);
+    }
+    return headers;
+}
+
+//! Table encoding through a temporary QBuffer per nesting level, to compare against.
+bool writeTableNestedBuffers(QIODevice *io, const QVariantHash &table)
+{
+    QByteArray packed;
+    QBuffer packedIo(&packed);
+    packedIo.open(QIODevice::WriteOnly);
+    for (auto it = table.constKeyValueBegin(); it != table.constKeyValueEnd(); ++it) {
+        const QByteArray name = it->first.toUtf8();
+        packedIo.putChar(char(name.size()));
+        packedIo.write(name);
+        if (it->second.typeId() == QMetaType::QVariantHash) {
+            packedIo.putChar('F');
+            if (!writeTableNestedBuffers(&packedIo, it->second.toHash())) {
+                return false;
+            }
+        } else if (!qmq::Frame::writeFieldValue(&packedIo, it->second)) {
+            return false;
+        }
+    }
+    std::array<char, 4> len;
+    qToBigEndian<quint32>(quint32(packed.size()), len.data());
+    return io->write(len.data(), 4) == 4 && io->write(packed) == packed.size();
+}
+} // namespace
+
+class BenchmarksTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        // Per-frame debug output would dominate the measurement.
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    void readDispatch_data()
+    {
+        QTest::addColumn<int>("maxFramesPerRead");
+        QTest::addColumn<int>("frameCount");
+
+        // A budget of one frame per read is the previous behaviour: one event loop
+        // iteration per frame.
+        QTest::newRow("one_frame_per_iteration") << 1 << 100000;
+        QTest::newRow("drain_512") << 512 << 100000;
+        QTest::newRow("drain_unlimited") << 0 << 100000;
+    }
+
+    void readDispatch()
+    {
+        const QFETCH(int, maxFramesPerRead);
+        const QFETCH(int, frameCount);
+
+        const QByteArray stream = makeFrameStream(frameCount);
+
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+        QElapsedTimer timer;
+        connect(&server, &QTcpServer::newConnection, this, [&]() {
+            QTcpSocket *peer = server.nextPendingConnection();
+            timer.start();
+            peer->write(stream);
+        });
+
+        qmq::Client client;
+        client.setMaxFramesPerRead(maxFramesPerRead);
+        client.setMaxBytesPerRead(0);
+        QSignalSpy disconnectSpy(&client, &qmq::Client::disconnected);
+        QVERIFY(client.connectToHost(
+            QUrl(QString("amqp://localhost:%1/").arg(server.serverPort()))));
+
+        QVERIFY(disconnectSpy.wait(waitMs));
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        QVERIFY(elapsedNs > 0);
+        QTest::setBenchmarkResult(qreal(frameCount) * 1e9 / qreal(elapsedNs),
+                                  QTest::FramesPerSecond);
+    }
+
+    void encodeFieldTable_data()
+    {
+        QTest::addColumn<bool>("inPlace");
+
+        QTest::newRow("nested_qbuffers") << false;
+        QTest::newRow("in_place") << true;
+    }
+
+    void encodeFieldTable()
+    {
+        const QFETCH(bool, inPlace);
+
+        const QVariantHash headers = makeNestedHeaders();
+        QByteArray expected;
+        {
+            QBuffer io(&expected);
+            io.open(QIODevice::WriteOnly);
+            QVERIFY(writeTableNestedBuffers(&io, headers));
+        }
+
+        QByteArray out;
+        out.reserve(expected.size());
+        QBENCHMARK {
+            out.resize(0);
+            if (inPlace) {
+                qmq::detail::ByteWriter writer(&out);
+                qmq::detail::writeTable(&writer, headers);
+            } else {
+                QBuffer io(&out);
+                io.open(QIODevice::WriteOnly);
+                writeTableNestedBuffers(&io, headers);
+            }
+        }
+        QCOMPARE(out, expected);
+    }
+
+    void decodeFieldTable()
+    {
+        const QVariantHash headers = makeNestedHeaders();
+        QByteArray encoded;
+        qmq::detail::ByteWriter writer(&encoded);
+        QVERIFY(qmq::detail::writeTable(&writer, headers));
+
+        QVariantHash decoded;
+        bool ok = true;
+        QBENCHMARK {
+            qmq::detail::ByteCursor cursor(encoded);
+            decoded = qmq::detail::readTable(&cursor, &ok);
+        }
+        QVERIFY(ok);
+        QCOMPARE(decoded.size(), headers.size());
+    }
+
+    void cleanupTestCase() {}
+};
+
+QTEST_MAIN(BenchmarksTest)
+
+#include <tst_benchmarks.moc>
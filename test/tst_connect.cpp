@@ -59,6 +59,32 @@ private Q_SLOTS:
         QVERIFY(disconnectSpy.wait(smallWaitMs));
     }
 
+    void testConnectCorked()
+    {
+        qmq::Client client;
+        client.setWriteMode(qmq::Client::WriteMode::Corked);
+        QCOMPARE(client.writeMode(), qmq::Client::WriteMode::Corked);
+        QSignalSpy spy(&client, &qmq::Client::connected);
+        QSignalSpy disconnectSpy(&client, &qmq::Client::disconnected);
+        client.connectToHost(QUrl(testUrl));
+        // The handshake only completes if frames are flushed once control returns to the loop.
+        QVERIFY(spy.wait(smallWaitMs));
+
+        auto channel = client.createChannel();
+        QFuture<void> openFut = channel->channelOpen();
+        QVERIFY(client.flush());
+        QVERIFY(waitForFuture(openFut));
+        QVERIFY(!openFut.isCanceled());
+
+        // Frames beyond the threshold are written without waiting for the event loop.
+        client.setFlushThresholdBytes(1);
+        QVERIFY(client.sendHeartbeat());
+
+        QVERIFY(waitForFuture(channel->channelClose(200, "OK", 0, 0)));
+        client.disconnectFromHost();
+        QVERIFY(disconnectSpy.wait(smallWaitMs));
+    }
+
     void cleanupTestCase()
     {
         //qDebug() << "Called after every test";
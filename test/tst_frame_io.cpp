@@ -1,5 +1,9 @@
 #include <qtrabbitmq/frame.h>
 
+#include "frame_writer.h"
+#include "spec_constants.h"
+#include "spec_methods.h"
+
 #include <QBuffer>
 #include <QDebug>
 #include <QObject>
@@ -129,6 +133,256 @@ private slots:
         QCOMPARE(buffer.size(), packedSizeInBytes);
     }
 
+    void testReadFrameFromBuffer()
+    {
+        qmq::MethodFrame method(3, 60, 40);
+        QVERIFY(method.setArguments(
+            {quint16(0), QString("exchange"), QString("key"), false, false}));
+        const QByteArray payload("0123456789");
+        const qmq::BodyFrame body(3, payload);
+
+        QBuffer out;
+        QVERIFY(out.open(QBuffer::WriteOnly));
+        QVERIFY(qmq::Frame::writeFrame(&out, 0, method));
+        QVERIFY(qmq::Frame::writeFrame(&out, 0, body));
+        const QByteArray buffer = out.data();
+
+        qsizetype offset = 0;
+        qmq::ErrorCode err = qmq::ErrorCode::NoError;
+        std::unique_ptr<qmq::Frame> frame = qmq::Frame::readFrame(buffer, &offset, 0, &err);
+        QVERIFY(frame);
+        QCOMPARE(frame->type(), qmq::FrameType::Method);
+        QCOMPARE(frame->channel(), quint16(3));
+        const auto *methodIn = static_cast<const qmq::MethodFrame *>(frame.get());
+        QCOMPARE(methodIn->classId(), quint16(60));
+        QCOMPARE(methodIn->methodId(), quint16(40));
+        QCOMPARE(methodIn->getArguments(), method.getArguments());
+        // Arguments refer to the receive buffer rather than a copy of it.
+        QVERIFY(methodIn->argumentsView().data() == buffer.constData() + 7 + 4);
+
+        frame = qmq::Frame::readFrame(buffer, &offset, 0, &err);
+        QVERIFY(frame);
+        QCOMPARE(frame->type(), qmq::FrameType::Body);
+        const auto *bodyIn = static_cast<const qmq::BodyFrame *>(frame.get());
+        QCOMPARE(bodyIn->body(), payload);
+        QVERIFY(bodyIn->bodyView().data() == buffer.constData() + offset - payload.size() - 1);
+        QCOMPARE(offset, buffer.size());
+
+        frame = qmq::Frame::readFrame(buffer, &offset, 0, &err);
+        QVERIFY(!frame);
+        QCOMPARE(err, qmq::ErrorCode::InsufficientDataAvailable);
+    }
+
+    void testReadFrameFromBufferPartial()
+    {
+        const qmq::BodyFrame body(1, QByteArray(100, 'x'));
+        QBuffer out;
+        QVERIFY(out.open(QBuffer::WriteOnly));
+        QVERIFY(qmq::Frame::writeFrame(&out, 0, body));
+        const QByteArray full = out.data();
+
+        for (qsizetype len = 0; len < full.size(); ++len) {
+            qsizetype offset = 0;
+            qmq::ErrorCode err = qmq::ErrorCode::NoError;
+            QVERIFY(!qmq::Frame::readFrame(full.left(len), &offset, 0, &err));
+            QCOMPARE(err, qmq::ErrorCode::InsufficientDataAvailable);
+            QCOMPARE(offset, qsizetype(0));
+        }
+
+        qsizetype offset = 0;
+        qmq::ErrorCode err = qmq::ErrorCode::NoError;
+        QVERIFY(!qmq::Frame::readFrame(full, &offset, 50, &err));
+        QCOMPARE(err, qmq::ErrorCode::FrameTooLarge);
+
+        QByteArray corrupt = full;
+        corrupt[corrupt.size() - 1] = 0;
+        QVERIFY(!qmq::Frame::readFrame(corrupt, &offset, 0, &err));
+        QCOMPARE(err, qmq::ErrorCode::InvalidFrameData);
+        QCOMPARE(offset, qsizetype(0));
+    }
+
+    void testReadHeaderFrameFromBuffer()
+    {
+        const QHash<qmq::BasicProperty, QVariant> props(
+            {{qmq::BasicProperty::ContentType, QString("text/plain")},
+             {qmq::BasicProperty::Headers, QVariantHash({{QString("k"), QVariant(1)}})},
+             {qmq::BasicProperty::DeliveryMode, QVariant::fromValue(quint8(2))}});
+        const qmq::HeaderFrame header(2, 60, 1234, props);
+        QBuffer out;
+        QVERIFY(out.open(QBuffer::WriteOnly));
+        QVERIFY(qmq::Frame::writeFrame(&out, 0, header));
+
+        qsizetype offset = 0;
+        qmq::ErrorCode err = qmq::ErrorCode::NoError;
+        std::unique_ptr<qmq::Frame> frame = qmq::Frame::readFrame(out.data(), &offset, 0, &err);
+        QVERIFY(frame);
+        QCOMPARE(frame->type(), qmq::FrameType::Header);
+        const auto *headerIn = static_cast<const qmq::HeaderFrame *>(frame.get());
+        QCOMPARE(headerIn->contentSize(), quint64(1234));
+        QCOMPARE(headerIn->properties(), props);
+    }
+
+    void testBasicProperties()
+    {
+        qmq::BasicProperties props;
+        QVERIFY(props.isEmpty());
+        props.setContentType("application/json");
+        props.setDeliveryMode(2);
+        props.setHeaders({{QString("k"), QVariant(1)}});
+        props.setTimestampSecs(1700000000);
+        props.setAppId("app");
+        QCOMPARE(props.flags(), quint16(0x8000 | 0x2000 | 0x1000 | 0x0040 | 0x0008));
+        QVERIFY(props.contains(qmq::BasicProperty::DeliveryMode));
+        QVERIFY(!props.contains(qmq::BasicProperty::Priority));
+
+        // Same wire format as the QVariant based properties.
+        const qmq::HeaderFrame typed(1, 60, 42, props);
+        const qmq::HeaderFrame generic(1, 60, 42, props.toHash());
+        QCOMPARE(typed.content(), generic.content());
+        QCOMPARE(qmq::BasicProperties::fromHash(props.toHash()), props);
+        QCOMPARE(props.value(qmq::BasicProperty::DeliveryMode),
+                 QVariant::fromValue(quint8(2)));
+        QCOMPARE(props.value(qmq::BasicProperty::Timestamp),
+                 QVariant(QDateTime::fromSecsSinceEpoch(1700000000)));
+
+        std::unique_ptr<qmq::HeaderFrame> decoded
+            = qmq::HeaderFrame::fromContent(1, typed.content());
+        QVERIFY(decoded);
+        QCOMPARE(decoded->contentSize(), quint64(42));
+        QCOMPARE(decoded->basicProperties(), props);
+
+        props.remove(qmq::BasicProperty::Headers);
+        QVERIFY(!props.contains(qmq::BasicProperty::Headers));
+        QVERIFY(props.headers().isEmpty());
+        QVERIFY(props != decoded->basicProperties());
+    }
+
+    void testTypedMethod()
+    {
+        qmq::spec::methods::basic::Deliver deliver;
+        deliver.consumerTag = "ctag";
+        deliver.deliveryTag = 1234567890123ULL;
+        deliver.redelivered = true;
+        deliver.exchange = "exchange";
+        deliver.routingKey = "key";
+
+        bool ok = false;
+        const qmq::MethodFrame typed = qmq::detail::encodeMethod(7, deliver, &ok);
+        QVERIFY(ok);
+        QCOMPARE(typed.classId(), qmq::spec::basic::ID_);
+        QCOMPARE(typed.methodId(), qmq::spec::basic::Deliver);
+
+        // Same encoding as the generic, QVariantList based arguments.
+        qmq::MethodFrame generic(7, qmq::spec::basic::ID_, qmq::spec::basic::Deliver);
+        QVERIFY(generic.setArguments({deliver.consumerTag,
+                                      QVariant::fromValue(deliver.deliveryTag),
+                                      deliver.redelivered,
+                                      deliver.exchange,
+                                      deliver.routingKey}));
+        QCOMPARE(typed.argumentsView().toByteArray(), generic.argumentsView().toByteArray());
+
+        qmq::spec::methods::basic::Deliver decoded;
+        QVERIFY(qmq::detail::decodeMethod(generic, &decoded));
+        QCOMPARE(decoded.consumerTag, deliver.consumerTag);
+        QCOMPARE(decoded.deliveryTag, deliver.deliveryTag);
+        QCOMPARE(decoded.redelivered, deliver.redelivered);
+        QCOMPARE(decoded.exchange, deliver.exchange);
+        QCOMPARE(decoded.routingKey, deliver.routingKey);
+
+        // Wrong method, and truncated arguments.
+        qmq::spec::methods::basic::GetOk getOk;
+        QVERIFY(!qmq::detail::decodeMethod(generic, &getOk));
+        const qmq::MethodFrame truncated(7,
+                                         qmq::spec::basic::ID_,
+                                         qmq::spec::basic::Deliver,
+                                         generic.argumentsView().mid(0, 10));
+        QVERIFY(!qmq::detail::decodeMethod(truncated, &decoded));
+    }
+
+    void testFrameWriterContent()
+    {
+        qmq::BasicProperties props;
+        props.setContentType("text/plain");
+        const QByteArray payload(100, 'p');
+
+        qmq::detail::FrameWriter writer(40);
+        QVERIFY(writer.writeContent(5, qmq::spec::basic::ID_, props, payload));
+        const QByteArray buffer = writer.buffer();
+
+        qsizetype offset = 0;
+        qmq::ErrorCode err = qmq::ErrorCode::NoError;
+        std::unique_ptr<qmq::Frame> frame = qmq::Frame::readFrame(buffer, &offset, 0, &err);
+        QVERIFY(frame);
+        QCOMPARE(frame->type(), qmq::FrameType::Header);
+        const auto *headerIn = static_cast<const qmq::HeaderFrame *>(frame.get());
+        QCOMPARE(headerIn->contentSize(), quint64(payload.size()));
+        QCOMPARE(headerIn->basicProperties(), props);
+
+        // Body frames carry at most maxFrameSize - 8 bytes each.
+        QByteArray body;
+        int bodyFrames = 0;
+        while (offset < buffer.size()) {
+            frame = qmq::Frame::readFrame(buffer, &offset, 40, &err);
+            QVERIFY(frame);
+            QCOMPARE(frame->type(), qmq::FrameType::Body);
+            QCOMPARE(frame->channel(), quint16(5));
+            body += static_cast<const qmq::BodyFrame *>(frame.get())->body();
+            ++bodyFrames;
+        }
+        QCOMPARE(bodyFrames, 4);
+        QCOMPARE(body, payload);
+
+        // A frame that does not fit is rolled back.
+        const qsizetype mark = writer.size();
+        qmq::MethodFrame method(5, 60, 40, QByteArray(64, 'a'));
+        QVERIFY(!writer.writeFrame(method));
+        QCOMPARE(writer.size(), mark);
+
+        QBuffer out;
+        QVERIFY(out.open(QBuffer::WriteOnly));
+        QVERIFY(writer.flush(&out));
+        QVERIFY(writer.isEmpty());
+        QCOMPARE(out.data(), buffer);
+    }
+
+    void testFrameWriterPublish()
+    {
+        qmq::spec::methods::basic::Publish publish;
+        publish.exchange = "exchange";
+        publish.routingKey = "key";
+        const QByteArray storage = QByteArray("header:") + QByteArray(3000, 'b');
+        const QByteArrayView payload = QByteArrayView(storage).mid(7);
+
+        // The whole publish is one contiguous buffer, so it goes out in a single write.
+        qmq::detail::FrameWriter writer(1024);
+        QVERIFY(writer.writeMethod(2, publish));
+        QVERIFY(writer.writeContent(2, publish.ClassId, qmq::BasicProperties(), payload));
+        const QByteArray buffer = writer.buffer();
+
+        qsizetype offset = 0;
+        qmq::ErrorCode err = qmq::ErrorCode::NoError;
+        std::unique_ptr<qmq::Frame> frame = qmq::Frame::readFrame(buffer, &offset, 1024, &err);
+        QVERIFY(frame);
+        QCOMPARE(frame->type(), qmq::FrameType::Method);
+        qmq::spec::methods::basic::Publish decoded;
+        QVERIFY(qmq::detail::decodeMethod(static_cast<const qmq::MethodFrame &>(*frame),
+                                          &decoded));
+        QCOMPARE(decoded.routingKey, publish.routingKey);
+
+        frame = qmq::Frame::readFrame(buffer, &offset, 1024, &err);
+        QVERIFY(frame);
+        QCOMPARE(frame->type(), qmq::FrameType::Header);
+
+        QByteArray body;
+        while (offset < buffer.size()) {
+            frame = qmq::Frame::readFrame(buffer, &offset, 1024, &err);
+            QVERIFY(frame);
+            QCOMPARE(frame->type(), qmq::FrameType::Body);
+            body += static_cast<const qmq::BodyFrame *>(frame.get())->body();
+        }
+        QCOMPARE(body, payload.toByteArray());
+    }
+
     void cleanupTestCase()
     {
         // qDebug("Called after myFirstTest and mySecondTest.");
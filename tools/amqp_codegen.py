@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""Generates src/libqtrabbitmq/spec_methods.h from the AMQP 0-9-1 spec XML.
+
+Each method of the spec becomes a plain struct in qmq::spec::methods::<class>, holding one
+typed member per (non-reserved) field, with encode()/decode() for its argument list.
+
+Usage:
+    tools/amqp_codegen.py [tools/amqp0-9-1.xml] [src/libqtrabbitmq/spec_methods.h]
+
+The output is checked in; re-run this script (or build the amqp_codegen target) after
+changing the spec XML.
+"""
+
+import os
+import sys
+import xml.etree.ElementTree as ET
+
+# AMQP type -> (C++ type, default initializer, reader, writer)
+TYPES = {
+    'bit': ('bool', 'false', None, None),
+    'octet': ('quint8', '0', 'detail::readValue<quint8>(in, &ok)',
+              'detail::writeValue<quint8>(out, {})'),
+    'short': ('quint16', '0', 'detail::readValue<quint16>(in, &ok)',
+              'detail::writeValue<quint16>(out, {})'),
+    'long': ('quint32', '0', 'detail::readValue<quint32>(in, &ok)',
+             'detail::writeValue<quint32>(out, {})'),
+    'longlong': ('quint64', '0', 'detail::readValue<quint64>(in, &ok)',
+                 'detail::writeValue<quint64>(out, {})'),
+    'shortstr': ('QString', None, 'detail::readShortStr(in, &ok)',
+                 'ok = detail::writeShortStr(out, {}) && ok'),
+    'longstr': ('QByteArray', None, 'detail::readLongStr(in, &ok)',
+                'detail::writeLongStr(out, {})'),
+    'timestamp': ('QDateTime', None, 'detail::readTimestamp(in, &ok)',
+                  'detail::writeTimestamp(out, {})'),
+    'table': ('QVariantHash', None, 'detail::readTable(in, &ok)',
+              'ok = detail::writeTable(out, {}) && ok'),
+}
+
+# Value written for reserved fields, by type.
+RESERVED_VALUES = {
+    'octet': 'quint8(0)',
+    'short': 'quint16(0)',
+    'long': 'quint32(0)',
+    'longlong': 'quint64(0)',
+    'shortstr': 'QString()',
+    'longstr': 'QByteArray()',
+    'timestamp': 'QDateTime()',
+    'table': 'QVariantHash()',
+}
+
+INDENT = '    '
+
+
+def camel_case(name, upper_first):
+    parts = name.split('-')
+    result = parts[0] + ''.join(p[:1].upper() + p[1:] for p in parts[1:])
+    if upper_first:
+        result = result[:1].upper() + result[1:]
+    return result
+
+
+class Field:
+    def __init__(self, element, domains):
+        self.name = element.get('name')
+        self.reserved = element.get('reserved') == '1'
+        domain = element.get('domain') or element.get('type')
+        self.type = domains.get(domain, domain)
+        if self.type not in TYPES:
+            raise ValueError('Unknown type %s for field %s' % (self.type, self.name))
+        self.member = camel_case(self.name, False)
+
+
+def group_fields(fields):
+    """Splits fields into runs; consecutive bits share one packed octet."""
+    groups = []
+    for field in fields:
+        if field.type == 'bit' and groups and groups[-1][0] == 'bits' and len(groups[-1][1]) < 8:
+            groups[-1][1].append(field)
+        elif field.type == 'bit':
+            groups.append(('bits', [field]))
+        else:
+            groups.append(('value', [field]))
+    return groups
+
+
+def emit_decode(fields, out):
+    if not fields:
+        out.append(INDENT + 'bool decode(detail::ByteCursor *) { return true; }')
+        return
+    out.append(INDENT + 'bool decode(detail::ByteCursor *in)')
+    out.append(INDENT + '{')
+    out.append(INDENT * 2 + 'bool ok = true;')
+    for kind, group in group_fields(fields):
+        if kind == 'bits':
+            if all(f.reserved for f in group):
+                out.append(INDENT * 2 + 'detail::readValue<quint8>(in, &ok);')
+                continue
+            out.append(INDENT * 2 + '{')
+            out.append(INDENT * 3 + 'const quint8 bits = detail::readValue<quint8>(in, &ok);')
+            for bit, field in enumerate(group):
+                if not field.reserved:
+                    out.append(INDENT * 3 + '%s = (bits & 0x%02x) != 0;'
+                               % (field.member, 1 << bit))
+            out.append(INDENT * 2 + '}')
+            continue
+        field = group[0]
+        reader = TYPES[field.type][2]
+        if field.reserved:
+            out.append(INDENT * 2 + '%s; // %s' % (reader, field.name))
+        else:
+            out.append(INDENT * 2 + '%s = %s;' % (field.member, reader))
+    out.append(INDENT * 2 + 'return ok;')
+    out.append(INDENT + '}')
+
+
+def emit_encode(fields, out):
+    if not fields:
+        out.append(INDENT + 'bool encode(detail::ByteWriter *) const { return true; }')
+        return
+    out.append(INDENT + 'bool encode(detail::ByteWriter *out) const')
+    out.append(INDENT + '{')
+    uses_ok = any(f.type in ('shortstr', 'table') for f in fields)
+    if uses_ok:
+        out.append(INDENT * 2 + 'bool ok = true;')
+    for kind, group in group_fields(fields):
+        if kind == 'bits':
+            terms = ['(%s ? 0x%02x : 0)' % (f.member, 1 << bit)
+                     for bit, f in enumerate(group) if not f.reserved]
+            if not terms:
+                out.append(INDENT * 2 + 'detail::writeValue<quint8>(out, quint8(0));')
+            elif len(terms) == 1:
+                out.append(INDENT * 2 + 'detail::writeValue<quint8>(out, quint8%s);' % terms[0])
+            else:
+                out.append(INDENT * 2 + 'detail::writeValue<quint8>(out,')
+                out.append(INDENT * 2 + ' ' * 27 + 'quint8(' + terms[0])
+                for term in terms[1:]:
+                    out.append(INDENT * 2 + ' ' * 32 + '| ' + term)
+                out[-1] += '));'
+            continue
+        field = group[0]
+        writer = TYPES[field.type][3]
+        value = RESERVED_VALUES[field.type] if field.reserved else field.member
+        out.append(INDENT * 2 + writer.format(value) + ';')
+    out.append(INDENT * 2 + ('return ok;' if uses_ok else 'return true;'))
+    out.append(INDENT + '}')
+
+
+def emit_method(class_name, method, domains, out):
+    struct = camel_case(method.get('name'), True)
+    fields = [Field(f, domains) for f in method.findall('field')]
+    out.append('struct %s' % struct)
+    out.append('{')
+    out.append(INDENT + 'static constexpr quint16 ClassId = %s;' % method.get('class-index'))
+    out.append(INDENT + 'static constexpr quint16 MethodId = %s;' % method.get('index'))
+    out.append(INDENT + 'static constexpr const char *Name = "%s.%s";'
+               % (class_name, method.get('name')))
+    members = [f for f in fields if not f.reserved]
+    if members:
+        out.append('')
+    for field in members:
+        cpp_type, default, _, _ = TYPES[field.type]
+        if default is None:
+            out.append(INDENT + '%s %s;' % (cpp_type, field.member))
+        else:
+            out.append(INDENT + '%s %s = %s;' % (cpp_type, field.member, default))
+    out.append('')
+    emit_decode(fields, out)
+    emit_encode(fields, out)
+    out.append('};')
+
+
+def generate(spec_path):
+    root = ET.parse(spec_path).getroot()
+    domains = {d.get('name'): d.get('type') for d in root.findall('domain')}
+
+    out = [
+        '// Generated by tools/amqp_codegen.py from tools/amqp0-9-1.xml. Do not edit.',
+        '#pragma once',
+        '',
+        '#include "amqp_codec.h"',
+        '',
+        '#include <QByteArray>',
+        '#include <QDateTime>',
+        '#include <QString>',
+        '#include <QVariant>',
+        '',
+        'namespace qmq::spec::methods {',
+    ]
+    for cls in root.findall('class'):
+        class_name = cls.get('name')
+        out.append('')
+        out.append('namespace %s {' % class_name)
+        first = True
+        for method in cls.findall('method'):
+            method.set('class-index', cls.get('index'))
+            if not first:
+                out.append('')
+            first = False
+            emit_method(class_name, method, domains, out)
+        out.append('} // namespace %s' % class_name)
+    out.append('')
+    out.append('} // namespace qmq::spec::methods')
+    return '\n'.join(out) + '\n'
+
+
+def main(argv):
+    here = os.path.dirname(os.path.abspath(__file__))
+    spec_path = argv[1] if len(argv) > 1 else os.path.join(here, 'amqp0-9-1.xml')
+    out_path = argv[2] if len(argv) > 2 else os.path.join(
+        here, '..', 'src', 'libqtrabbitmq', 'spec_methods.h')
+    text = generate(spec_path)
+    with open(out_path, 'w', newline='\n') as f:
+        f.write(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))